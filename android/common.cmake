@@ -19,6 +19,7 @@ include_directories(
     ${root_dir}/third_party/SDL/include
     ${root_dir}/third_party/spdlog/include
     ${root_dir}/third_party/thread-pool-cpp/include
+    ${root_dir}/third_party/zstd/lib
     ${root_dir}/src
     ${ANDROID_NDK}/sources/third_party/vulkan/src/include
 )
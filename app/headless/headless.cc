@@ -25,7 +25,11 @@
 static const int kElementCount = 32;
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("headless.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("headless.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   auto lbuffer_loader = std::static_pointer_cast<xg::LayoutBufferLoader>(
       layout->Find("deviceBufferLoader"));
@@ -20,14 +20,19 @@
 #include "xg/types.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("hello_reality.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("hello_reality.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   auto model_matrix_data =
       std::static_pointer_cast<xg::LayoutData>(layout->Find("mainModelMatrix"));
   if (!model_matrix_data) return nullptr;
 
   std::memcpy(const_cast<float*>(glm::value_ptr(model_matrix_)),
-              model_matrix_data->data.data(), model_matrix_data->data.size());
+              model_matrix_data->data->GetData(),
+              model_matrix_data->data->GetSize());
 
   return layout;
 }
@@ -19,7 +19,11 @@
 #include "xg/window_viewer.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("hello_world.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("hello_world.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
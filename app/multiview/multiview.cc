@@ -18,7 +18,11 @@
 #include "xg/window_viewer.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("multiview.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("multiview.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
@@ -19,7 +19,11 @@
 #include "xg/window_viewer.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("multiwin.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("multiwin.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
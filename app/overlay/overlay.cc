@@ -20,7 +20,11 @@
 #include "xg/viewer.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("overlay.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("overlay.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
@@ -19,7 +19,11 @@
 #include "xg/viewer.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("render_to_skybox.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("render_to_skybox.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
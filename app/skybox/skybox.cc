@@ -19,7 +19,11 @@
 #include "xg/viewer.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("skybox.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("skybox.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
@@ -14,7 +14,11 @@
 #include "xg/parser.h"
 
 std::shared_ptr<xg::Layout> Application::CreateLayout() const {
+#ifdef XG_COMPILED_LAYOUT
+  auto layout = xg::Layout::Deserialize("triangle.xgl");
+#else
   auto layout = xg::Parser::Get().ParseFile("triangle.xml");
+#endif  // XG_COMPILED_LAYOUT
 
   return layout;
 }
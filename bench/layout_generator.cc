@@ -0,0 +1,149 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "layout_generator.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static void WriteHeader(std::ofstream& out, const std::string& shader_path) {
+  out << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+         "<Engine>\n"
+         "  <Renderer appName=\"xg_bench\">\n"
+         "    <Device>\n"
+         "      <Queue id=\"mainQueue\" queueFamily=\"Graphics Transfer\"/>\n"
+         "    </Device>\n"
+         "  </Renderer>\n"
+         "\n"
+         "  <Constant id=\"viewportWidth\" value=\"640\"/>\n"
+         "  <Constant id=\"viewportHeight\" value=\"480\"/>\n"
+         "\n"
+         "  <RenderPass id=\"mainRenderPass\">\n"
+         "    <Attachment id=\"mainColorAttachment\" format=\"B8G8R8A8Unorm\""
+         " loadOp=\"Clear\" storeOp=\"Store\" finalLayout=\"PresentSrc\"/>\n"
+         "    <Subpass id=\"mainSubpass\">\n"
+         "      <ColorAttachment attachment=\"mainColorAttachment\""
+         " layout=\"ColorAttachmentOptimal\"/>\n"
+         "    </Subpass>\n"
+         "  </RenderPass>\n"
+         "\n"
+         "  <PipelineLayout id=\"drawPipelineLayout\">\n"
+         "    <PushConstantRange stageFlags=\"Vertex\" size=\"4*16\"/>\n"
+         "  </PipelineLayout>\n"
+         "\n"
+         "  <ShaderModule id=\"drawVertexShader\" file=\""
+      << shader_path
+      << "\"/>\n"
+         "  <ShaderModule id=\"drawFragmentShader\" file=\""
+      << shader_path << "\"/>\n\n";
+}
+
+static void WritePipeline(std::ofstream& out, int index) {
+  out << "  <GraphicsPipeline id=\"drawPipeline" << index
+      << "\" layout=\"drawPipelineLayout\" renderPass=\"mainRenderPass\""
+         " subpass=\"mainSubpass\">\n"
+         "    <Stage stage=\"Vertex\" module=\"drawVertexShader\"/>\n"
+         "    <Stage stage=\"Fragment\" module=\"drawFragmentShader\"/>\n"
+         "    <VertexInputState>\n"
+         "      <VertexBindingDescription binding=\"0\" stride=\"(3+3+2)*4\""
+         " inputRate=\"Vertex\"/>\n"
+         "      <VertexAttributeDescription location=\"0\" binding=\"0\""
+         " format=\"R32G32B32Sfloat\" offset=\"0\"/>\n"
+         "      <VertexAttributeDescription location=\"1\" binding=\"0\""
+         " format=\"R32G32B32Sfloat\" offset=\"3*4\"/>\n"
+         "      <VertexAttributeDescription location=\"2\" binding=\"0\""
+         " format=\"R32G32Sfloat\" offset=\"(3+3)*4\"/>\n"
+         "    </VertexInputState>\n"
+         "    <InputAssemblyState topology=\"TriangleList\"/>\n"
+         "    <ViewportState>\n"
+         "      <Viewport width=\"viewportWidth\" height=\"viewportHeight\""
+         " maxDepth=\"1.0\"/>\n"
+         "      <Scissor/>\n"
+         "    </ViewportState>\n"
+         "    <RasterizationState polygonMode=\"Fill\" cullMode=\"Back\""
+         " frontFace=\"Clockwise\" lineWidth=\"1.0\"/>\n"
+         "    <MultisampleState/>\n"
+         "    <DepthStencilState depthTestEnable=\"true\""
+         " depthWriteEnable=\"true\"/>\n"
+         "    <ColorBlendState>\n"
+         "      <Attachment/>\n"
+         "    </ColorBlendState>\n"
+         "  </GraphicsPipeline>\n";
+}
+
+static void WriteData(std::ofstream& out, int index, int float_count) {
+  static constexpr int kValuesPerLine = 8;
+  char value[32];
+
+  out << "  <Data id=\"drawData" << index << "\">\n";
+  for (int i = 0; i < float_count; i += kValuesPerLine) {
+    out << "    <FloatValues>";
+    for (int j = i; j < i + kValuesPerLine && j < float_count; ++j) {
+      std::snprintf(value, sizeof(value), j == i ? "%.3f" : " %.3f",
+                    static_cast<float>((index + j) % 2000) * 0.001f - 1.0f);
+      out << value;
+    }
+    out << "</FloatValues>\n";
+  }
+  out << "  </Data>\n";
+}
+
+// Nests the command groups |group_depth| levels deep.
+static void WriteCommandGroups(std::ofstream& out,
+                               const LayoutGeneratorInfo& info) {
+  for (int i = 0; i < info.group_depth; ++i) {
+    const std::string indent(2 + i * 2, ' ');
+
+    out << indent << "<CommandGroup";
+    if (i == 0) out << " id=\"mainCommandGroup\"";
+    out << ">\n" << indent << "  <CommandList>\n";
+
+    if (info.pipeline_count > 0) {
+      out << indent << "    <BindPipeline pipeline=\"drawPipeline"
+          << i % info.pipeline_count << "\"/>\n";
+    }
+    if (info.data_count > 0) {
+      out << indent << "    <PushConstants layout=\"drawPipelineLayout\""
+          << " stageFlags=\"Vertex\" data=\"drawData" << i % info.data_count
+          << "\"/>\n";
+    }
+    out << indent << "    <Draw vertexCount=\"3\" instanceCount=\"1\"/>\n"
+        << indent << "  </CommandList>\n";
+  }
+
+  for (int i = info.group_depth - 1; i >= 0; --i) {
+    out << std::string(2 + i * 2, ' ') << "</CommandGroup>\n";
+  }
+}
+
+bool GenerateLayout(const LayoutGeneratorInfo& info,
+                    const std::string& xml_path,
+                    const std::string& shader_path) {
+  {
+    // only the header of a SPIR-V module, the shaders are never created
+    static const uint32_t code[] = {0x07230203, 0x00010000, 0, 1, 0};
+    std::ofstream shader(shader_path, std::ios::binary);
+    shader.write(reinterpret_cast<const char*>(code), sizeof(code));
+    if (!shader) return false;
+  }
+
+  std::ofstream out(xml_path, std::ios::binary);
+  if (!out) return false;
+
+  WriteHeader(out, shader_path);
+  for (int i = 0; i < info.pipeline_count; ++i) WritePipeline(out, i);
+  for (int i = 0; i < info.data_count; ++i) {
+    WriteData(out, i, info.float_count);
+  }
+  WriteCommandGroups(out, info);
+  out << "</Engine>\n";
+
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,27 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#ifndef BENCH_LAYOUT_GENERATOR_H_
+#define BENCH_LAYOUT_GENERATOR_H_
+
+#include <string>
+
+struct LayoutGeneratorInfo {
+  int pipeline_count = 256;
+  int data_count = 256;
+  int float_count = 4096;
+  int group_depth = 32;
+};
+
+// Writes a synthetic layout which parses and resolves, but is not meant to
+// be run by the engine. The shader modules refer to a dummy shader file.
+bool GenerateLayout(const LayoutGeneratorInfo& info,
+                    const std::string& xml_path,
+                    const std::string& shader_path);
+
+#endif  // BENCH_LAYOUT_GENERATOR_H_
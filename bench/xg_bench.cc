@@ -0,0 +1,284 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "layout_generator.h"
+#include "xg/layout.h"
+#include "xg/mapped_file.h"
+#include "xg/parser.h"
+
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+struct Sample {
+  std::chrono::steady_clock::time_point time;
+  size_t allocations;
+};
+
+static Sample TakeSample() {
+  return {std::chrono::steady_clock::now(),
+          allocation_count.load(std::memory_order_relaxed)};
+}
+
+// Resets the peak resident size to the current one, so that the peak of
+// each phase is measured on its own rather than over the process lifetime.
+static bool ResetPeakResidentSize() {
+#if defined(__linux__)
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.close();
+  return static_cast<bool>(clear_refs);
+#else
+  return false;
+#endif
+}
+
+static size_t GetPeakResidentSize() {
+#if defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return static_cast<size_t>(std::strtoull(line.c_str() + 6, nullptr, 10)) *
+             1024;
+    }
+  }
+#endif
+  return 0;
+}
+
+static size_t GetResidentSize() {
+#if defined(__linux__)
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0;
+  size_t resident = 0;
+  if (statm >> size >> resident) {
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+struct Memory {
+  size_t begin = 0;
+  size_t end = 0;
+  size_t peak = 0;  // 0 if the peak could not be reset
+};
+
+static size_t ToMegabytes(size_t bytes) { return bytes / (1024 * 1024); }
+
+static void ReportMemory(const char* phase, const Memory& memory) {
+  if (memory.end == 0) return;
+
+  std::cout << phase << " rss: " << ToMegabytes(memory.begin) << " -> "
+            << ToMegabytes(memory.end) << " MB";
+  if (memory.peak > 0) {
+    std::cout << ", peak " << ToMegabytes(memory.peak) << " MB";
+  }
+  std::cout << std::endl;
+}
+
+// Counts the start tags, which is cheap enough not to need a parser.
+static size_t CountElements(const xg::MappedFile& file) {
+  const auto data = reinterpret_cast<const char*>(file.GetData());
+  size_t count = 0;
+
+  for (size_t i = 0; i + 1 < file.GetSize(); ++i) {
+    if (data[i] != '<') continue;
+
+    const char c = data[i + 1];
+    if (c != '/' && c != '!' && c != '?') ++count;
+  }
+  return count;
+}
+
+static void Report(const char* phase, const Sample& begin, const Sample& end,
+                   size_t elements, size_t bytes) {
+  const auto seconds =
+      std::chrono::duration<double>(end.time - begin.time).count();
+  const auto per_second = [seconds](double value) {
+    return seconds > 0.0 ? value / seconds : 0.0;
+  };
+  char line[160];
+
+  std::snprintf(line, sizeof(line),
+                "%-12s %10.2f ms %14.0f elements/s %10.2f MB/s %12zu allocs",
+                phase, seconds * 1000.0, per_second(elements),
+                per_second(bytes / (1024.0 * 1024.0)),
+                end.allocations - begin.allocations);
+  std::cout << line << std::endl;
+}
+
+static void PrintUsage() {
+  std::cout << "usage: xg_bench [options] [layout.xml]\n"
+               "  --pipelines N   graphics pipelines to generate\n"
+               "  --data M        data blocks to generate\n"
+               "  --floats K      floats in each data block\n"
+               "  --depth D       depth of the nested command groups\n"
+               "  --stream        parse in streaming mode\n"
+               "  --zstd          serialize compressed with zstd\n"
+               "  --sectioned     serialize in sections with mappable blobs\n"
+               "a given layout is benchmarked instead of a generated one"
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  LayoutGeneratorInfo info;
+  auto mode = xg::ParseMode::kDocument;
+  xg::LayoutSerializeInfo serialize_info;
+  std::string xml_path;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg(argv[i]);
+    const bool has_value = i + 1 < argc;
+
+    if (arg == "--stream") {
+      mode = xg::ParseMode::kStream;
+    } else if (arg == "--zstd") {
+      serialize_info.codec = xg::LayoutCodec::kZstd;
+    } else if (arg == "--sectioned") {
+      serialize_info.sectioned = true;
+    } else if (arg == "--pipelines" && has_value) {
+      info.pipeline_count = std::atoi(argv[++i]);
+    } else if (arg == "--data" && has_value) {
+      info.data_count = std::atoi(argv[++i]);
+    } else if (arg == "--floats" && has_value) {
+      info.float_count = std::atoi(argv[++i]);
+    } else if (arg == "--depth" && has_value) {
+      info.group_depth = std::atoi(argv[++i]);
+    } else if (arg[0] != '-' && xml_path.empty()) {
+      xml_path = arg;
+    } else {
+      PrintUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (xml_path.empty()) {
+    xml_path = "xg_bench.xml";
+    if (!GenerateLayout(info, xml_path, "xg_bench.spv")) {
+      std::cerr << "failed to generate layout: " << xml_path << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  size_t xml_size = 0;
+  {
+    const auto xml = xg::MappedFile::Open(xml_path);
+    if (!xml) return EXIT_FAILURE;
+    xml_size = xml->GetSize();
+  }
+
+  auto& parser = xg::Parser::Get();
+  Sample parsed = {};
+  bool has_parsed = false;
+  parser.SetParsedHandler([&parsed, &has_parsed](const xg::Layout&) {
+    parsed = TakeSample();
+    has_parsed = true;
+  });
+
+  Memory parse_memory;
+  const bool parse_peak = ResetPeakResidentSize();
+  parse_memory.begin = GetResidentSize();
+  const auto parse_begin = TakeSample();
+  auto layout = parser.ParseFile(xml_path, mode);
+  const auto parse_end = TakeSample();
+  parse_memory.end = GetResidentSize();
+  if (parse_peak) parse_memory.peak = GetPeakResidentSize();
+  parser.SetParsedHandler(nullptr);
+  if (!layout) return EXIT_FAILURE;
+
+  // counted after the parse is measured, as it reads the whole file
+  size_t elements = 0;
+  {
+    const auto xml = xg::MappedFile::Open(xml_path);
+    if (!xml) return EXIT_FAILURE;
+    elements = CountElements(*xml);
+  }
+
+  std::cout << xml_path << ": " << elements << " elements, " << xml_size
+            << " bytes, "
+            << (mode == xg::ParseMode::kStream ? "stream" : "document")
+            << " mode" << std::endl;
+
+  if (has_parsed) {
+    Report("parse", parse_begin, parsed, elements, xml_size);
+    Report("resolve", parsed, parse_end, elements, xml_size);
+  } else {
+    // the layout did not go through the parser, such as a cached one
+    Report("load", parse_begin, parse_end, elements, xml_size);
+  }
+
+  const std::string bin_path = "xg_bench.bin";
+  Memory serialize_memory;
+  const bool serialize_peak = ResetPeakResidentSize();
+  serialize_memory.begin = GetResidentSize();
+  const auto serialize_begin = TakeSample();
+  if (!layout->Serialize(bin_path, serialize_info)) return EXIT_FAILURE;
+  const auto serialize_end = TakeSample();
+  serialize_memory.end = GetResidentSize();
+  if (serialize_peak) serialize_memory.peak = GetPeakResidentSize();
+
+  size_t bin_size = 0;
+  {
+    const auto bin = xg::MappedFile::Open(bin_path);
+    if (!bin) return EXIT_FAILURE;
+    bin_size = bin->GetSize();
+  }
+  layout.reset();
+
+  const auto deserialize_begin = TakeSample();
+  layout = xg::Layout::Deserialize(bin_path);
+  const auto deserialize_end = TakeSample();
+  if (!layout) return EXIT_FAILURE;
+
+  Report("serialize", serialize_begin, serialize_end, elements, bin_size);
+  Report("deserialize", deserialize_begin, deserialize_end, elements,
+         bin_size);
+
+  // only what the pipelines need, without commands and data
+  if (serialize_info.sectioned) {
+    layout.reset();
+
+    const auto load_begin = TakeSample();
+    const auto reader = xg::LayoutReader::Open(bin_path);
+    if (!reader || !reader->Load(xg::LayoutSection::kPipelines)) {
+      return EXIT_FAILURE;
+    }
+    const auto load_end = TakeSample();
+    Report("pipelines", load_begin, load_end, elements, bin_size);
+  }
+
+  ReportMemory("parse", parse_memory);
+  ReportMemory("serialize", serialize_memory);
+
+  return 0;
+}
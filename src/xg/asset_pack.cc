@@ -0,0 +1,382 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "xg/asset_pack.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SDL.h"
+#include "xg/logger.h"
+#include "xg/mapped_file.h"
+#include "xg/types.h"
+#include "xg/utility.h"
+#include "zstd.h"
+
+namespace xg {
+
+static constexpr uint32_t kAssetPackMagic = 0x50414758;  // "XGAP"
+static constexpr uint32_t kAssetPackVersion = 1;
+
+struct AssetPackHeader {
+  uint32_t magic = kAssetPackMagic;
+  uint32_t version = kAssetPackVersion;
+  uint32_t entry_count = 0;
+  uint32_t reserved = 0;
+  uint64_t directory_offset = 0;  // the entries, then their paths
+  uint64_t directory_size = 0;
+};
+
+struct AssetPack::Entry {
+  uint64_t hash;
+  uint64_t offset;
+  uint64_t size;
+  uint64_t stored_size;
+  uint64_t name_offset;
+  uint32_t name_size;
+  LayoutCodec codec;
+};
+
+// "./shaders\a.spv" and "shaders/a.spv" name the same entry.
+static std::string_view NormalizePath(std::string_view path,
+                                      std::string* buffer) {
+  if (path.find('\\') != std::string_view::npos) {
+    buffer->assign(path);
+    std::replace(buffer->begin(), buffer->end(), '\\', '/');
+    path = *buffer;
+  }
+  while (path.size() > 2 && path[0] == '.' && path[1] == '/') {
+    path.remove_prefix(2);
+  }
+  return path;
+}
+
+static uint64_t HashPath(std::string_view path) {
+  return HashData(path.data(), path.size());
+}
+
+static size_t Align(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool AssetPack::Create(const std::string& filepath,
+                       const std::vector<std::string>& files,
+                       const AssetPackInfo& info) {
+  auto* rw = SDL_RWFromFile(filepath.c_str(), "wb");
+  if (!rw) {
+    XG_ERROR("failed to open file: {}, error: {}", filepath, SDL_GetError());
+    return false;
+  }
+
+  static const char zeros[kAlignment] = {};
+  const auto write = [rw](const void* data, size_t size) {
+    return size == 0 || SDL_RWwrite(rw, data, size, 1) == 1;
+  };
+
+  AssetPackHeader header;
+  bool result = write(&header, sizeof(header));
+
+  std::vector<Entry> entries;
+  std::string names;
+  std::vector<uint8_t> compressed;
+  size_t position = Align(sizeof(header), kAlignment);
+  result = result && write(zeros, position - sizeof(header));
+
+  for (const auto& file_path : files) {
+    if (!result) break;
+
+    std::string buffer;
+    const auto name = NormalizePath(file_path, &buffer);
+    const auto hash = HashPath(name);
+    const auto duplicate = std::find_if(
+        entries.begin(), entries.end(), [&](const Entry& entry) {
+          return entry.hash == hash &&
+                 names.compare(entry.name_offset, entry.name_size, name) == 0;
+        });
+    if (duplicate != entries.end()) {
+      XG_WARN("duplicate asset skipped: {}", file_path);
+      continue;
+    }
+
+    const auto file = MappedFile::Open(file_path);
+    if (!file) {
+      result = false;
+      break;
+    }
+
+    Entry entry = {};
+    entry.hash = hash;
+    entry.offset = position;
+    entry.size = file->GetSize();
+    entry.stored_size = file->GetSize();
+    entry.name_offset = names.size();
+    entry.name_size = static_cast<uint32_t>(name.size());
+    entry.codec = LayoutCodec::kNone;
+    const void* data = file->GetData();
+
+    if (info.codec == LayoutCodec::kZstd && file->GetSize() > 0) {
+      compressed.resize(ZSTD_compressBound(file->GetSize()));
+      const auto size =
+          ZSTD_compress(compressed.data(), compressed.size(), file->GetData(),
+                        file->GetSize(), info.level);
+      if (ZSTD_isError(size)) {
+        XG_ERROR("zstd error: {}", ZSTD_getErrorName(size));
+        result = false;
+        break;
+      }
+      if (size < file->GetSize()) {
+        entry.stored_size = size;
+        entry.codec = LayoutCodec::kZstd;
+        data = compressed.data();
+      }
+    }
+
+    const auto stored_size = static_cast<size_t>(entry.stored_size);
+    const auto next = Align(position + stored_size, kAlignment);
+    result = write(data, stored_size) &&
+             write(zeros, next - position - stored_size);
+    position = next;
+
+    names.append(name);
+    entries.emplace_back(entry);
+  }
+
+  if (result) {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+    const auto names_offset = position + entries.size() * sizeof(Entry);
+    for (auto& entry : entries) entry.name_offset += names_offset;
+
+    header.entry_count = static_cast<uint32_t>(entries.size());
+    header.directory_offset = position;
+    header.directory_size = entries.size() * sizeof(Entry) + names.size();
+    result = write(entries.data(), entries.size() * sizeof(Entry)) &&
+             write(names.data(), names.size()) &&
+             SDL_RWseek(rw, 0, RW_SEEK_SET) == 0 &&
+             write(&header, sizeof(header));
+  }
+
+  if (SDL_RWclose(rw) != 0 || !result) {
+    XG_ERROR("failed to write file: {}", filepath);
+    return false;
+  }
+
+  XG_DEBUG("asset pack: {}, {} entries", filepath, entries.size());
+
+  return true;
+}
+
+static bool ReadAt(SDL_RWops* rw, size_t offset, void* data, size_t size) {
+  return SDL_RWseek(rw, static_cast<Sint64>(offset), RW_SEEK_SET) ==
+             static_cast<Sint64>(offset) &&
+         (size == 0 || SDL_RWread(rw, data, size, 1) == 1);
+}
+
+std::shared_ptr<AssetPack> AssetPack::Open(const std::string& filepath) {
+  auto pack = std::make_shared<AssetPack>();
+  if (!pack) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+  pack->filepath_ = filepath;
+
+  AssetPackHeader header;
+  header.magic = 0;
+  size_t file_size = 0;
+
+  auto file = MappedFile::Map(filepath);
+  if (file) {
+    file_size = file->GetSize();
+    if (file_size >= sizeof(header)) {
+      std::memcpy(&header, file->GetData(), sizeof(header));
+    }
+  } else {
+    pack->rw_ = SDL_RWFromFile(filepath.c_str(), "rb");
+    if (!pack->rw_) {
+      XG_ERROR("failed to open file: {}, error: {}", filepath,
+               SDL_GetError());
+      return nullptr;
+    }
+    const auto size = SDL_RWsize(pack->rw_);
+    file_size = size > 0 ? static_cast<size_t>(size) : 0;
+    if (file_size >= sizeof(header) &&
+        !ReadAt(pack->rw_, 0, &header, sizeof(header))) {
+      header.magic = 0;
+    }
+  }
+
+  if (header.magic != kAssetPackMagic || header.version != kAssetPackVersion ||
+      header.directory_offset % kAlignment != 0 ||
+      header.directory_offset > file_size ||
+      header.directory_size > file_size - header.directory_offset ||
+      header.entry_count >
+          header.directory_size / sizeof(Entry)) {
+    XG_ERROR("invalid asset pack: {}", filepath);
+    return nullptr;
+  }
+
+  const auto directory_offset = static_cast<size_t>(header.directory_offset);
+  const auto directory_size = static_cast<size_t>(header.directory_size);
+  if (file) {
+    pack->directory_ =
+        MappedFile::Slice(file, directory_offset, directory_size);
+  } else {
+    pack->directory_ = pack->Read(directory_offset, directory_size);
+  }
+  if (!pack->directory_) return nullptr;
+
+  // checked once, so that lookups need not
+  const auto* entries =
+      reinterpret_cast<const Entry*>(pack->directory_->GetData());
+  for (uint32_t i = 0; i < header.entry_count; ++i) {
+    const auto& entry = entries[i];
+    if (entry.offset > file_size || entry.stored_size > file_size ||
+        entry.offset + entry.stored_size > file_size ||
+        entry.name_offset < directory_offset ||
+        entry.name_offset > file_size ||
+        entry.name_size > file_size - entry.name_offset ||
+        entry.name_offset + entry.name_size >
+            directory_offset + directory_size ||
+        (entry.codec != LayoutCodec::kNone &&
+         entry.codec != LayoutCodec::kZstd) ||
+        (entry.codec == LayoutCodec::kNone &&
+         entry.size != entry.stored_size) ||
+        (i > 0 && entries[i - 1].hash > entry.hash)) {
+      XG_ERROR("invalid asset pack: {}", filepath);
+      return nullptr;
+    }
+  }
+
+  pack->file_ = std::move(file);
+  pack->directory_offset_ = directory_offset;
+  pack->entries_ = entries;
+  pack->entry_count_ = header.entry_count;
+
+  return pack;
+}
+
+AssetPack::~AssetPack() {
+  if (rw_) SDL_RWclose(rw_);
+}
+
+std::shared_ptr<MappedFile> AssetPack::Read(size_t offset,
+                                            size_t size) const {
+  assert(rw_);
+
+  // not value-initialized, the whole buffer is overwritten by the read
+  std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[size]);
+  if (!data) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!ReadAt(rw_, offset, data.get(), size)) {
+    XG_ERROR("failed to read file: {}, error: {}", filepath_, SDL_GetError());
+    return nullptr;
+  }
+  return MappedFile::Wrap(std::move(data), size);
+}
+
+std::shared_ptr<MappedFile> AssetPack::Find(const std::string& path) const {
+  std::string buffer;
+  const auto name = NormalizePath(path, &buffer);
+  const auto hash = HashPath(name);
+
+  const auto range = std::equal_range(
+      entries_, entries_ + entry_count_, Entry{hash},
+      [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+  for (auto entry = range.first; entry != range.second; ++entry) {
+    const std::string_view entry_name(
+        reinterpret_cast<const char*>(directory_->GetData() +
+                                      entry->name_offset - directory_offset_),
+        entry->name_size);
+    if (entry_name != name) continue;
+
+    XG_DEBUG("asset: {} in {}", path, filepath_);
+
+    const auto offset = static_cast<size_t>(entry->offset);
+    const auto size = static_cast<size_t>(entry->size);
+    const auto stored_size = static_cast<size_t>(entry->stored_size);
+    if (entry->codec == LayoutCodec::kNone) {
+      return file_ ? MappedFile::Slice(file_, offset, size)
+                   : Read(offset, size);
+    }
+
+    const auto stored =
+        file_ ? MappedFile::Slice(file_, offset, stored_size)
+              : Read(offset, stored_size);
+    if (!stored) return nullptr;
+
+    std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[size]);
+    if (!data) {
+      XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+      return nullptr;
+    }
+
+    const auto result =
+        ZSTD_decompress(data.get(), size, stored->GetData(), stored_size);
+    if (ZSTD_isError(result) || result != size) {
+      XG_ERROR("corrupted asset: {} in {}", path, filepath_);
+      return nullptr;
+    }
+    return MappedFile::Wrap(std::move(data), size);
+  }
+  return nullptr;
+}
+
+bool AssetPackRegistry::Mount(const std::string& filepath) {
+  auto pack = AssetPack::Open(filepath);
+  if (!pack) return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  packs_.emplace_back(std::move(pack));
+  return true;
+}
+
+void AssetPackRegistry::Unmount(const std::string& filepath) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  packs_.erase(std::remove_if(packs_.begin(), packs_.end(),
+                              [&filepath](const auto& pack) {
+                                return pack->GetFilePath() == filepath;
+                              }),
+               packs_.end());
+}
+
+void AssetPackRegistry::UnmountAll() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  packs_.clear();
+}
+
+std::shared_ptr<MappedFile> AssetPackRegistry::Find(
+    const std::string& path) const {
+  std::vector<std::shared_ptr<AssetPack>> packs;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (packs_.empty()) return nullptr;
+    packs = packs_;
+  }
+
+  for (auto it = packs.rbegin(); it != packs.rend(); ++it) {
+    auto file = (*it)->Find(path);
+    if (file) return file;
+  }
+  return nullptr;
+}
+
+}  // namespace xg
@@ -0,0 +1,105 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#ifndef XG_ASSET_PACK_H_
+#define XG_ASSET_PACK_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "xg/layout.h"
+#include "xg/mapped_file.h"
+
+struct SDL_RWops;
+
+namespace xg {
+
+struct AssetPackInfo {
+  LayoutCodec codec = LayoutCodec::kNone;
+  int level = 3;
+};
+
+// One file holding many, each entry aligned and optionally compressed. The
+// directory is sorted by the hash of the entry paths.
+class AssetPack {
+ public:
+  static constexpr size_t kAlignment = 16;
+
+  // Packs |files| under the paths they are given by. An entry is only kept
+  // compressed if that makes it smaller.
+  static bool Create(const std::string& filepath,
+                     const std::vector<std::string>& files,
+                     const AssetPackInfo& info = {});
+  // The pack is mapped where MappedFile::Map can map it. Otherwise only its
+  // directory is read, and the entries are read through SDL when found.
+  static std::shared_ptr<AssetPack> Open(const std::string& filepath);
+
+  AssetPack() = default;
+  ~AssetPack();
+
+  // Uncompressed entries are views of the mapped pack, compressed entries
+  // are decompressed on every call.
+  std::shared_ptr<MappedFile> Find(const std::string& path) const;
+
+  const std::string& GetFilePath() const { return filepath_; }
+  size_t GetEntryCount() const { return entry_count_; }
+
+  struct Entry;
+
+ private:
+  AssetPack(const AssetPack&) = delete;
+  AssetPack& operator=(const AssetPack&) = delete;
+  AssetPack(AssetPack&&) = delete;
+  AssetPack& operator=(AssetPack&&) = delete;
+
+  std::shared_ptr<MappedFile> Read(size_t offset, size_t size) const;
+
+  std::string filepath_;
+  std::shared_ptr<MappedFile> file_;
+  std::shared_ptr<MappedFile> directory_;
+  size_t directory_offset_ = 0;
+  const Entry* entries_ = nullptr;
+  size_t entry_count_ = 0;
+
+  // only when the pack is not mapped
+  mutable std::mutex mutex_;
+  SDL_RWops* rw_ = nullptr;
+};
+
+// The mounted packs, which MappedFile::Open and LoadFile search, the most
+// recently mounted first, before the file system.
+class AssetPackRegistry {
+ public:
+  static AssetPackRegistry& Get() {
+    static AssetPackRegistry registry;
+    return registry;
+  }
+
+  bool Mount(const std::string& filepath);
+  void Unmount(const std::string& filepath);
+  void UnmountAll();
+
+  std::shared_ptr<MappedFile> Find(const std::string& path) const;
+
+ private:
+  AssetPackRegistry() = default;
+  AssetPackRegistry(const AssetPackRegistry&) = delete;
+  AssetPackRegistry& operator=(const AssetPackRegistry&) = delete;
+  AssetPackRegistry(AssetPackRegistry&&) = delete;
+  AssetPackRegistry& operator=(AssetPackRegistry&&) = delete;
+
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<AssetPack>> packs_;
+};
+
+}  // namespace xg
+
+#endif  // XG_ASSET_PACK_H_
@@ -18,6 +18,7 @@
 #include "xg/device.h"
 #include "xg/layout.h"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/resource_loader.h"
 #include "xg/thread_pool.h"
 #include "xg/types.h"
@@ -50,6 +51,35 @@ void BufferLoader::Run(std::shared_ptr<Task> self) {
   auto data_size = info_.size;
   if (data_size == -1) data_size = dst_buffer->GetSize();
 
+  // a deferred blob is read from the layout file here, on the loader thread
+  const auto* src_ptr = static_cast<const uint8_t*>(info_.src_ptr);
+  auto src_size = info_.src_size;
+  std::shared_ptr<MappedFile> file;
+
+  if (!src_ptr && info_.blob) {
+    src_ptr = info_.blob->GetData();
+    if (!src_ptr) return;
+    src_size = info_.blob->GetSize();
+  } else if (!src_ptr) {
+    file = MappedFile::Open(info_.file_path);
+    if (!file) return;
+    src_ptr = file->GetData();
+    src_size = file->GetSize();
+  }
+
+  if (info_.src_offset > src_size || data_size > src_size - info_.src_offset) {
+    XG_ERROR("buffer loader source out of range: {} + {} > {}",
+             info_.src_offset, data_size, src_size);
+    return;
+  }
+  if (info_.dst_offset > dst_buffer->GetSize() ||
+      data_size > dst_buffer->GetSize() - info_.dst_offset) {
+    XG_ERROR("buffer loader destination out of range: {} + {} > {}",
+             info_.dst_offset, data_size, dst_buffer->GetSize());
+    return;
+  }
+  src_ptr += info_.src_offset;
+
   CommandBufferBeginInfo begin_info = {};
   begin_info.usage = CommandBufferUsage::kOneTimeSubmit;
   xg::CommandBuffer* cmd = nullptr;
@@ -73,17 +103,7 @@ void BufferLoader::Run(std::shared_ptr<Task> self) {
     const auto& staging_data =
         static_cast<uint8_t*>(context_->staging_buffer->MapMemory());
 
-    if (info_.src_ptr) {
-      const auto* src_ptr =
-          static_cast<const uint8_t*>(info_.src_ptr) + info_.src_offset;
-      std::copy(src_ptr, src_ptr + lbuffer.size, staging_data);
-    } else {
-      std::vector<uint8_t> file_data;
-      if (!LoadFile(info_.file_path, &file_data)) return;
-
-      const auto* src_ptr = file_data.data() + info_.src_offset;
-      std::copy(src_ptr, src_ptr + lbuffer.size, staging_data);
-    }
+    std::copy(src_ptr, src_ptr + lbuffer.size, staging_data);
 
     context_->staging_buffer->UnmapMemory();
 
@@ -150,17 +170,7 @@ void BufferLoader::Run(std::shared_ptr<Task> self) {
   } else {
     auto* data = static_cast<uint8_t*>(dst_buffer->MapMemory());
 
-    if (info_.src_ptr) {
-      const auto* src_ptr =
-          static_cast<const uint8_t*>(info_.src_ptr) + info_.src_offset;
-      std::copy(src_ptr, src_ptr + data_size, data);
-    } else {
-      std::vector<uint8_t> file_data;
-      if (!LoadFile(info_.file_path, &file_data)) return;
-
-      const auto* src_ptr = file_data.data() + info_.src_offset;
-      std::copy(src_ptr, src_ptr + data_size, data);
-    }
+    std::copy(src_ptr, src_ptr + data_size, data);
 
     for (int i = 1; i < info_.dst_buffers.size(); ++i) {
       auto* dst_data = static_cast<uint8_t*>(info_.dst_buffers[i]->MapMemory());
@@ -216,4 +226,10 @@ void BufferLoader::Run(std::shared_ptr<Task> self) {
   result_ = 0;
 }
 
+void BufferLoader::OnFinished() {
+  info_.src_ptr = nullptr;
+  info_.blob.reset();
+  info_.mapped_file.reset();
+}
+
 }  // namespace xg
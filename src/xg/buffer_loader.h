@@ -14,15 +14,21 @@
 #include <vector>
 
 #include "xg/buffer.h"
+#include "xg/mapped_file.h"
 #include "xg/queue.h"
 #include "xg/resource_loader.h"
 #include "xg/types.h"
 
 namespace xg {
 
+struct LayoutBlob;
+
 struct BufferLoaderInfo {
   std::string file_path;
   const void* src_ptr = nullptr;
+  size_t src_size = 0;  // the bytes at |src_ptr|
+  std::shared_ptr<MappedFile> mapped_file;
+  std::shared_ptr<LayoutBlob> blob;  // read when |src_ptr| is null
   std::vector<Buffer*> dst_buffers;
   size_t src_offset = 0;
   size_t dst_offset = 0;
@@ -39,6 +45,8 @@ class BufferLoader : public ResourceLoader {
   void Run(std::shared_ptr<Task> self) override;
 
  protected:
+  void OnFinished() override;
+
   BufferLoaderInfo info_;
 };
 
@@ -184,10 +184,14 @@ CommandBuffer* CommandContext::GetCommandBuffer(int frame) const {
   }
 }
 
-void CommandFunction::Init(LayoutFunction* lfunction) {
+bool CommandFunction::Init(LayoutFunction* lfunction) {
   if (lfunction->ldata) {
-    data_ = lfunction->ldata->data;
+    const auto& data = lfunction->ldata->data;
+    const auto bytes = data->GetData();
+    if (!bytes && data->GetSize() != 0) return false;
+    data_.assign(bytes, bytes + data->GetSize());
   }
+  return true;
 }
 
 bool CommandPipelineBarrier::Init(
@@ -704,7 +708,7 @@ void CommandBlitImage::Build(const CommandInfo& cmd_info) const {
   cmd_info.cmd_buffer->BlitImage(info);
 }
 
-void CommandPushConstants::Init(LayoutPushConstants* lpush_constants) {
+bool CommandPushConstants::Init(LayoutPushConstants* lpush_constants) {
   info_.layout = std::static_pointer_cast<PipelineLayout>(
                      lpush_constants->llayout->instance)
                      .get();
@@ -712,13 +716,17 @@ void CommandPushConstants::Init(LayoutPushConstants* lpush_constants) {
   info_.offset = lpush_constants->offset;
 
   if (lpush_constants->ldata) {
-    data_ = lpush_constants->ldata->data;
+    const auto& data = lpush_constants->ldata->data;
+    const auto bytes = data->GetData();
+    if (!bytes && data->GetSize() != 0) return false;
+    data_.assign(bytes, bytes + data->GetSize());
     info_.size = data_.size();
     info_.values = data_.data();
   } else {
     info_.size = lpush_constants->size;
     info_.values = lpush_constants->values;
   }
+  return true;
 }
 
 void CommandPushConstants::Build(const CommandInfo& cmd_info) const {
@@ -113,7 +113,7 @@ class CommandFunction : public CommandBase {
  public:
   virtual ~CommandFunction() = default;
 
-  void Init(LayoutFunction* lfunction);
+  bool Init(LayoutFunction* lfunction);
   void Build(const CommandInfo& cmd_info) const override {
     build_handler_(this, cmd_info);
   }
@@ -351,7 +351,7 @@ class CommandPushConstants : public CommandBase {
  public:
   virtual ~CommandPushConstants() = default;
 
-  void Init(LayoutPushConstants* lpush_constants);
+  bool Init(LayoutPushConstants* lpush_constants);
   void Build(const CommandInfo& cmd_info) const override;
   void SetData(const void* data, size_t size);
 
@@ -9,10 +9,18 @@
 #include "xg/engine.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "xg/command.h"
 #include "xg/command_buffer.h"
@@ -29,6 +37,7 @@
 #include "xg/image_loader.h"
 #include "xg/layout.h"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/pipeline_layout.h"
 #include "xg/queue.h"
 #include "xg/render_pass.h"
@@ -52,6 +61,134 @@
 
 namespace xg {
 
+// A step of Engine::PostInit, run once the stages it depends on are done.
+struct InitStage {
+  const char* name;
+  std::function<bool()> func;
+  std::vector<const char*> dependencies;
+  bool calling_thread = false;  // not on a worker, e.g. for the window system
+};
+
+// Runs the stages on the thread pool, as many at a time as are ready, and
+// one on the calling thread. The stages are declared after the ones they
+// depend on, which is the order they are run in on a worker thread.
+class InitStageGraph {
+ public:
+  explicit InitStageGraph(const std::vector<InitStage>& stages);
+
+  bool Run();
+
+ private:
+  class StageTask : public Task {
+   public:
+    StageTask(InitStageGraph* graph, size_t index)
+        : graph_(graph), index_(index) {}
+
+    void Run(std::shared_ptr<Task> self) override { graph_->Execute(index_); }
+
+   private:
+    InitStageGraph* graph_;
+    size_t index_;
+  };
+
+  void Execute(size_t index);
+
+  const std::vector<InitStage>& stages_;
+  std::vector<size_t> pending_counts_;
+  std::vector<std::vector<size_t>> dependents_;
+  std::deque<size_t> ready_;
+  size_t finished_count_ = 0;
+  std::atomic<bool> failed_{false};
+  std::mutex mutex_;
+  std::condition_variable finished_;
+};
+
+InitStageGraph::InitStageGraph(const std::vector<InitStage>& stages)
+    : stages_(stages),
+      pending_counts_(stages.size()),
+      dependents_(stages.size()) {
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    for (const auto dependency : stages_[i].dependencies) {
+      const auto it = std::find_if(stages_.begin(), stages_.begin() + i,
+                                   [dependency](const auto& stage) {
+                                     return std::strcmp(stage.name,
+                                                        dependency) == 0;
+                                   });
+      assert(it != stages_.begin() + i);
+
+      dependents_[it - stages_.begin()].emplace_back(i);
+      ++pending_counts_[i];
+    }
+  }
+}
+
+bool InitStageGraph::Run() {
+  auto& thread_pool = ThreadPool::Get();
+
+  // waiting on the workers from one of them might never return
+  if (thread_pool.IsWorkerThread() || thread_pool.GetWorkerCount() == 0) {
+    for (const auto& stage : stages_) {
+      if (!stage.func()) return false;
+    }
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    if (pending_counts_[i] == 0) ready_.emplace_back(i);
+  }
+
+  while (finished_count_ < stages_.size()) {
+    if (ready_.empty()) {
+      finished_.wait(lock);
+      continue;
+    }
+
+    auto it = std::find_if(ready_.begin(), ready_.end(), [this](size_t index) {
+      return stages_[index].calling_thread;
+    });
+    if (it == ready_.end()) it = ready_.begin();
+    const auto index = *it;
+    ready_.erase(it);
+
+    std::vector<size_t> posted;
+    std::deque<size_t> kept;
+    for (const auto ready : ready_) {
+      if (stages_[ready].calling_thread) {
+        kept.emplace_back(ready);
+      } else {
+        posted.emplace_back(ready);
+      }
+    }
+    ready_ = std::move(kept);
+    lock.unlock();
+
+    for (const auto ready : posted) {
+      thread_pool.Post(
+          ThreadPool::Job(std::make_shared<StageTask>(this, ready)));
+    }
+    Execute(index);
+
+    lock.lock();
+  }
+  return !failed_;
+}
+
+void InitStageGraph::Execute(size_t index) {
+  // the stages after a failed one are only counted
+  if (!failed_ && !stages_[index].func()) {
+    XG_ERROR("init stage failed: {}", stages_[index].name);
+    failed_ = true;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto dependent : dependents_[index]) {
+    if (--pending_counts_[dependent] == 0) ready_.emplace_back(dependent);
+  }
+  ++finished_count_;
+  finished_.notify_one();
+}
+
 Engine::~Engine() {
   ResourceLoader::Terminate();
 
@@ -92,49 +229,84 @@ bool Engine::Init(std::shared_ptr<Layout> layout) {
 }
 
 bool Engine::PostInit(const std::shared_ptr<Layout>& layout) {
-  if (!CreateBuffers(*layout)) return false;
-  if (!CreateBufferLoaders(*layout)) return false;
-  if (!CreateImages(*layout)) return false;
-  if (!CreateImageLoaders(*layout)) return false;
-  if (!CreateSamplers(*layout)) return false;
-  if (!CreateDescriptorSetLayouts(*layout)) return false;
-  if (!CreateDescriptorPools(layout.get())) return false;
-  if (!CreateRenderPasses(*layout)) return false;
-  if (!CreateOverlays(*layout)) return false;
-  if (!CreateShaderModules(*layout)) return false;
-  if (!CreatePipelineLayouts(*layout)) return false;
-  if (!CreateComputePipelines(*layout)) return false;
-  if (!CreateGraphicsPipelines(*layout)) return false;
-  if (!CreateSemaphores(*layout)) return false;
-  if (!CreateQueryPools(*layout)) return false;
-  if (!CreateEvents(*layout)) return false;
-  if (!CreateCameras(*layout)) return false;
-
-  FinishResourceLoaders();
-
-  if (!CreateImageViews(*layout)) return false;
-  if (!CreateDescriptorSets(*layout)) return false;
-  if (!CreateFramebuffers(*layout)) return false;
-  if (!CreateCommandLists(*layout)) return false;
-  if (!CreateCommandGroups(*layout)) return false;
-  if (!CreateCommandContexts(*layout)) return false;
-  if (!CreateQueueSubmits(*layout)) return false;
-  if (!CreateQueuePresents(*layout)) return false;
+  const auto& l = *layout;
+  const std::vector<InitStage> stages = {
+      {"buffers", [&] { return CreateBuffers(l); }},
+      {"buffer loaders", [&] { return CreateBufferLoaders(l); }, {"buffers"}},
+      {"images", [&] { return CreateImages(l); }},
+      {"image loaders", [&] { return CreateImageLoaders(l); }, {"images"}},
+      {"samplers", [&] { return CreateSamplers(l); }},
+      {"descriptor set layouts", [&] { return CreateDescriptorSetLayouts(l); }},
+      {"descriptor pools", [&] { return CreateDescriptorPools(layout.get()); }},
+      {"render passes", [&] { return CreateRenderPasses(l); }},
+      {"overlays",
+       [&] { return CreateOverlays(l); },
+       {"descriptor pools", "render passes"},
+       true},
+      {"shader modules", [&] { return CreateShaderModules(l); }},
+      {"pipeline layouts",
+       [&] { return CreatePipelineLayouts(l); },
+       {"descriptor set layouts"}},
+      {"compute pipelines",
+       [&] { return CreateComputePipelines(l); },
+       {"shader modules", "pipeline layouts"}},
+      {"graphics pipelines",
+       [&] { return CreateGraphicsPipelines(l); },
+       {"shader modules", "pipeline layouts", "render passes"}},
+      {"semaphores", [&] { return CreateSemaphores(l); }},
+      {"query pools", [&] { return CreateQueryPools(l); }},
+      {"events", [&] { return CreateEvents(l); }},
+      {"cameras", [&] { return CreateCameras(l); }},
+      // waits for the loaders, which run on the workers
+      {"resource loaders",
+       [&] {
+         FinishResourceLoaders();
+         return true;
+       },
+       {"buffer loaders", "image loaders", "overlays"},
+       true},
+      {"image views",
+       [&] { return CreateImageViews(l); },
+       {"resource loaders"}},
+      {"descriptor sets",
+       [&] { return CreateDescriptorSets(l); },
+       {"image views", "samplers", "descriptor set layouts",
+        "descriptor pools"}},
+      {"framebuffers",
+       [&] { return CreateFramebuffers(l); },
+       {"image views", "render passes"}},
+  };
+
+  InitStageGraph graph(stages);
+  if (!graph.Run()) return false;
+
+  // the commands refer to about everything created above
+  if (!CreateCommandLists(l)) return false;
+  if (!CreateCommandGroups(l)) return false;
+  if (!CreateCommandContexts(l)) return false;
+  if (!CreateQueueSubmits(l)) return false;
+  if (!CreateQueuePresents(l)) return false;
 
 #ifdef XG_ENABLE_REALITY
   if (layout->lreality) {
-    if (!CreateReferenceSpace(*layout)) return false;
-    if (!CreateCompositionLayerProjection(*layout)) return false;
+    if (!CreateReferenceSpace(l)) return false;
+    if (!CreateCompositionLayerProjection(l)) return false;
   }
 #endif  // XG_ENABLE_REALITY
 
-  if (!CreateViewers(*layout)) return false;
+  if (!CreateViewers(l)) return false;
 
-  CreateDebugMarkers(*layout);
+  CreateDebugMarkers(l);
 
   return true;
 }
 
+void Engine::AddInstance(const std::string& id,
+                         std::shared_ptr<void> instance) {
+  std::lock_guard<std::mutex> lock(instance_id_mutex_);
+  instance_id_map_.insert(std::make_pair(id, std::move(instance)));
+}
+
 void Engine::AddSystemLayouts(Layout* layout) {
   // for resource loader
   auto lres_loader = layout->lres_loader;
@@ -182,7 +354,7 @@ bool Engine::CreateWindows(Layout* layout) {
     if (!win) return false;
 
     if (!lwin->id.empty())
-      instance_id_map_.insert(std::make_pair(lwin->id, win));
+      AddInstance(lwin->id, win);
 
     lwin->instance = win;
 
@@ -200,7 +372,7 @@ bool Engine::CreateDevice(Layout* layout) {
   ldevice->instance = device;
 
   if (!ldevice->id.empty())
-    instance_id_map_.insert(std::make_pair(ldevice->id, device));
+    AddInstance(ldevice->id, device);
 
   device_ = std::move(device);
   return true;
@@ -226,7 +398,7 @@ bool Engine::CreateSwapchains(const Layout& layout) {
     lswapchain->instance = swapchain;
 
     if (!lswapchain->id.empty())
-      instance_id_map_.insert(std::make_pair(lswapchain->id, swapchain));
+      AddInstance(lswapchain->id, swapchain);
 
     swapchains_.emplace_back(std::move(swapchain));
   }
@@ -245,7 +417,7 @@ bool Engine::CreateQueues(Layout* layout) {
     lqueue->instance = queue;
 
     if (!lqueue->id.empty())
-      instance_id_map_.insert(std::make_pair(lqueue->id, queue));
+      AddInstance(lqueue->id, queue);
   }
   return true;
 }
@@ -262,7 +434,7 @@ bool Engine::CreateCommandPools(const Layout& layout) {
     lcmd_pool->instance = cmd_pool;
 
     if (!lcmd_pool->id.empty())
-      instance_id_map_.insert(std::make_pair(lcmd_pool->id, cmd_pool));
+      AddInstance(lcmd_pool->id, cmd_pool);
 
     cmd_pools_.emplace_back(std::move(cmd_pool));
   }
@@ -282,7 +454,7 @@ bool Engine::CreateCommandBuffers(const Layout& layout) {
       if (!cmd_buffers) return false;
 
       if (!lcmd_buffer->id.empty())
-        instance_id_map_.insert(std::make_pair(lcmd_buffer->id, cmd_buffers));
+        AddInstance(lcmd_buffer->id, cmd_buffers);
 
       lcmd_buffer->instance = std::move(cmd_buffers);
     } else {
@@ -304,7 +476,7 @@ bool Engine::CreateCommandBuffers(const Layout& layout) {
       lcmd_buffer->instance = cmd_buffer;
 
       if (!lcmd_buffer->id.empty())
-        instance_id_map_.insert(std::make_pair(lcmd_buffer->id, cmd_buffer));
+        AddInstance(lcmd_buffer->id, cmd_buffer);
     }
 
     cmd_buffers_.insert(cmd_buffers_.end(), cmd_buffers.begin(),
@@ -322,7 +494,7 @@ bool Engine::CreateFences(const Layout& layout) {
       if (!fences) return false;
 
       if (!lfence->id.empty())
-        instance_id_map_.insert(std::make_pair(lfence->id, fences));
+        AddInstance(lfence->id, fences);
 
       lfence->instance = std::move(fences);
     } else {
@@ -332,7 +504,7 @@ bool Engine::CreateFences(const Layout& layout) {
       lfence->instance = fence;
 
       if (!lfence->id.empty())
-        instance_id_map_.insert(std::make_pair(lfence->id, fence));
+        AddInstance(lfence->id, fence);
 
       fences_.emplace_back(std::move(fence));
     }
@@ -411,8 +583,29 @@ bool Engine::CreateBuffers(const Layout& layout) {
 
     if (!lbuffer_loader->data && lbuffer_loader->ldata) {
       const auto ldata = lbuffer_loader->ldata.get();
-      lbuffer_loader->size = ldata->data.size();
-      lbuffer_loader->data = ldata->data.data();
+
+      if (!ldata->file.empty()) {
+        if (!ldata->mapped_file) {
+          ldata->mapped_file = MappedFile::Open(ldata->file);
+          if (!ldata->mapped_file) return false;
+        }
+        const auto file_size = ldata->mapped_file->GetSize();
+        if (ldata->offset > file_size) {
+          XG_ERROR("data offset out of range: {} > {}", ldata->offset,
+                   file_size);
+          return false;
+        }
+        lbuffer_loader->size = std::min(ldata->size, file_size - ldata->offset);
+        lbuffer_loader->data = ldata->mapped_file->GetData() + ldata->offset;
+        lbuffer_loader->data_size = lbuffer_loader->size;
+      } else {
+        // a deferred blob is read by the loader, when it runs
+        lbuffer_loader->size = ldata->data->GetSize();
+        if (!ldata->data->IsDeferred()) {
+          lbuffer_loader->data = ldata->data->GetData();
+          lbuffer_loader->data_size = lbuffer_loader->size;
+        }
+      }
 
       if (lbuffer->size == 0) lbuffer->size = lbuffer_loader->size;
     }
@@ -426,7 +619,7 @@ bool Engine::CreateBuffers(const Layout& layout) {
       if (!buffers) return false;
 
       if (!lbuffer->id.empty())
-        instance_id_map_.insert(std::make_pair(lbuffer->id, buffers));
+        AddInstance(lbuffer->id, buffers);
 
       lbuffer->instance = std::move(buffers);
     } else {
@@ -436,7 +629,7 @@ bool Engine::CreateBuffers(const Layout& layout) {
       lbuffer->instance = buffer;
 
       if (!lbuffer->id.empty())
-        instance_id_map_.insert(std::make_pair(lbuffer->id, std::move(buffer)));
+        AddInstance(lbuffer->id, std::move(buffer));
     }
   }
   return true;
@@ -450,6 +643,11 @@ bool Engine::CreateBufferLoaders(const Layout& layout) {
     BufferLoaderInfo info = {};
     info.file_path = lbuffer_loader->file;
     info.src_ptr = lbuffer_loader->data;
+    info.src_size = lbuffer_loader->data_size;
+    if (lbuffer_loader->ldata) {
+      info.mapped_file = lbuffer_loader->ldata->mapped_file;
+      if (!info.src_ptr) info.blob = lbuffer_loader->ldata->data;
+    }
 
     if (lbuffer->lframe) {
       const auto& buffers =
@@ -479,6 +677,11 @@ bool Engine::CreateBufferLoaders(const Layout& layout) {
 
     buffer_loaders_.emplace_back(std::move(loader));
   }
+
+  // the loaders keep the mappings alive until they are finished
+  for (auto& lbuffer_loader : layout.lbuffer_loaders) {
+    if (lbuffer_loader->ldata) lbuffer_loader->ldata->mapped_file.reset();
+  }
   return true;
 }
 
@@ -512,7 +715,7 @@ bool Engine::CreateImages(const Layout& layout) {
     limage->instance = image;
 
     if (!limage->id.empty())
-      instance_id_map_.insert(std::make_pair(limage->id, std::move(image)));
+      AddInstance(limage->id, std::move(image));
   }
   return true;
 }
@@ -555,8 +758,7 @@ bool Engine::CreateImageViews(const Layout& layout) {
     limage_view->instance = image_view;
 
     if (!limage_view->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(limage_view->id, std::move(image_view)));
+      AddInstance(limage_view->id, std::move(image_view));
   }
   return true;
 }
@@ -571,7 +773,7 @@ bool Engine::CreateSamplers(const Layout& layout) {
     lsampler->instance = sampler;
 
     if (!lsampler->id.empty())
-      instance_id_map_.insert(std::make_pair(lsampler->id, std::move(sampler)));
+      AddInstance(lsampler->id, std::move(sampler));
   }
   return true;
 }
@@ -587,8 +789,7 @@ bool Engine::CreateDescriptorSetLayouts(const Layout& layout) {
     ldesc_set_layout->instance = desc_set_layout;
 
     if (!ldesc_set_layout->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(ldesc_set_layout->id, std::move(desc_set_layout)));
+      AddInstance(ldesc_set_layout->id, std::move(desc_set_layout));
   }
   return true;
 }
@@ -606,8 +807,7 @@ bool Engine::CreateDescriptorPools(Layout* layout) {
     ldesc_pool->instance = desc_pool;
 
     if (!ldesc_pool->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(ldesc_pool->id, std::move(desc_pool)));
+      AddInstance(ldesc_pool->id, std::move(desc_pool));
   }
 
   // calculates max_sets and pool_sizes
@@ -666,8 +866,7 @@ bool Engine::CreateDescriptorPools(Layout* layout) {
     ldesc_pool->instance = desc_pool;
 
     if (!ldesc_pool->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(ldesc_pool->id, std::move(desc_pool)));
+      AddInstance(ldesc_pool->id, std::move(desc_pool));
   }
   return true;
 }
@@ -688,7 +887,7 @@ bool Engine::CreateDescriptorSets(const Layout& layout) {
       ldesc_set->instance = desc_sets;
 
       if (!ldesc_set->id.empty())
-        instance_id_map_.insert(std::make_pair(ldesc_set->id, desc_sets));
+        AddInstance(ldesc_set->id, desc_sets);
 
       // expands layout nodes of frame for UpdateDescriptorSets()
       int i = 0;
@@ -802,7 +1001,7 @@ bool Engine::CreateDescriptorSets(const Layout& layout) {
       ldesc_set->instance = desc_set;
 
       if (!ldesc_set->id.empty())
-        instance_id_map_.insert(std::make_pair(ldesc_set->id, desc_set));
+        AddInstance(ldesc_set->id, desc_set);
     }
   }
 
@@ -830,8 +1029,7 @@ bool Engine::CreateRenderPasses(const Layout& layout) {
     lrender_pass->instance = render_pass;
 
     if (!lrender_pass->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(lrender_pass->id, std::move(render_pass)));
+      AddInstance(lrender_pass->id, std::move(render_pass));
   }
   return true;
 }
@@ -846,10 +1044,9 @@ bool Engine::CreateShaderModules(const Layout& layout) {
     lshader_module->instance = shader_module;
 
     if (!lshader_module->id.empty()) {
-      instance_id_map_.insert(
-          std::make_pair(lshader_module->id, std::move(shader_module)));
+      AddInstance(lshader_module->id, std::move(shader_module));
     }
-    lshader_module->code.clear();
+    lshader_module->code.reset();
   }
   return true;
 }
@@ -864,8 +1061,7 @@ bool Engine::CreatePipelineLayouts(const Layout& layout) {
     lpipeline_layout->instance = pipeline_layout;
 
     if (!lpipeline_layout->id.empty()) {
-      instance_id_map_.insert(
-          std::make_pair(lpipeline_layout->id, std::move(pipeline_layout)));
+      AddInstance(lpipeline_layout->id, std::move(pipeline_layout));
     }
   }
   return true;
@@ -892,8 +1088,7 @@ bool Engine::CreateComputePipelines(const Layout& layout) {
       lcompute_pipeline->instance = pipeline;
 
       if (!lcompute_pipeline->id.empty()) {
-        instance_id_map_.insert(
-            std::make_pair(lcompute_pipeline->id, pipeline));
+        AddInstance(lcompute_pipeline->id, pipeline);
       }
     }
   }
@@ -921,8 +1116,7 @@ bool Engine::CreateGraphicsPipelines(const Layout& layout) {
       lgraphics_pipeline->instance = pipeline;
 
       if (!lgraphics_pipeline->id.empty()) {
-        instance_id_map_.insert(
-            std::make_pair(lgraphics_pipeline->id, pipeline));
+        AddInstance(lgraphics_pipeline->id, pipeline);
       }
     }
   }
@@ -938,7 +1132,7 @@ bool Engine::CreateSemaphores(const Layout& layout) {
       if (!semaphores) return false;
 
       if (!lsemaphore->id.empty())
-        instance_id_map_.insert(std::make_pair(lsemaphore->id, semaphores));
+        AddInstance(lsemaphore->id, semaphores);
 
       lsemaphore->instance = std::move(semaphores);
     } else {
@@ -948,7 +1142,7 @@ bool Engine::CreateSemaphores(const Layout& layout) {
       lsemaphore->instance = semaphore;
 
       if (!lsemaphore->id.empty())
-        instance_id_map_.insert(std::make_pair(lsemaphore->id, semaphore));
+        AddInstance(lsemaphore->id, semaphore);
 
       semaphores_.emplace_back(std::move(semaphore));
     }
@@ -966,7 +1160,7 @@ bool Engine::CreateFramebuffers(const Layout& layout) {
       if (!framebuffers) return false;
 
       if (!lframebuffer->id.empty())
-        instance_id_map_.insert(std::make_pair(lframebuffer->id, framebuffers));
+        AddInstance(lframebuffer->id, framebuffers);
 
       lframebuffer->instance = std::move(framebuffers);
     } else {
@@ -991,8 +1185,7 @@ bool Engine::CreateFramebuffers(const Layout& layout) {
       lframebuffer->instance = framebuffer;
 
       if (!lframebuffer->id.empty()) {
-        instance_id_map_.insert(
-            std::make_pair(lframebuffer->id, std::move(framebuffer)));
+        AddInstance(lframebuffer->id, std::move(framebuffer));
       }
     }
   }
@@ -1008,7 +1201,7 @@ bool Engine::CreateQueryPools(const Layout& layout) {
       if (!query_pools) return false;
 
       if (!lquery_pool->id.empty())
-        instance_id_map_.insert(std::make_pair(lquery_pool->id, query_pools));
+        AddInstance(lquery_pool->id, query_pools);
 
       lquery_pool->instance = std::move(query_pools);
     } else {
@@ -1018,8 +1211,7 @@ bool Engine::CreateQueryPools(const Layout& layout) {
       lquery_pool->instance = query_pool;
 
       if (!lquery_pool->id.empty()) {
-        instance_id_map_.insert(
-            std::make_pair(lquery_pool->id, std::move(query_pool)));
+        AddInstance(lquery_pool->id, std::move(query_pool));
       }
     }
   }
@@ -1035,7 +1227,7 @@ bool Engine::CreateEvents(const Layout& layout) {
       if (!events) return false;
 
       if (!levent->id.empty())
-        instance_id_map_.insert(std::make_pair(levent->id, events));
+        AddInstance(levent->id, events);
 
       levent->instance = std::move(events);
     } else {
@@ -1045,7 +1237,7 @@ bool Engine::CreateEvents(const Layout& layout) {
       levent->instance = event;
 
       if (!levent->id.empty())
-        instance_id_map_.insert(std::make_pair(levent->id, std::move(event)));
+        AddInstance(levent->id, std::move(event));
     }
   }
   return true;
@@ -1073,7 +1265,7 @@ bool Engine::CreateCameras(const Layout& layout) {
     if (!camera) return false;
 
     if (!lcamera->id.empty())
-      instance_id_map_.insert(std::make_pair(lcamera->id, camera));
+      AddInstance(lcamera->id, camera);
 
     lcamera->instance = std::move(camera);
   }
@@ -1088,13 +1280,13 @@ bool Engine::CreateCommandLists(const Layout& layout) {
     if (!cmd_list) return false;
 
     if (!lcmd_list->id.empty())
-      instance_id_map_.insert(std::make_pair(lcmd_list->id, cmd_list));
+      AddInstance(lcmd_list->id, cmd_list);
 
     lcmd_list->instance = std::move(cmd_list);
 
     for (const auto& lcmd : lcmd_list->lcmds) {
       if (!lcmd->id.empty())
-        instance_id_map_.insert(std::make_pair(lcmd->id, lcmd->instance));
+        AddInstance(lcmd->id, lcmd->instance);
     }
   }
   return true;
@@ -1108,7 +1300,7 @@ bool Engine::CreateCommandGroups(const Layout& layout) {
     if (!cmd_group) return false;
 
     if (!lcmd_group->id.empty())
-      instance_id_map_.insert(std::make_pair(lcmd_group->id, cmd_group));
+      AddInstance(lcmd_group->id, cmd_group);
 
     lcmd_group->instance = std::move(cmd_group);
   }
@@ -1135,7 +1327,7 @@ bool Engine::CreateCommandContexts(const Layout& layout) {
     if (!cmd_context) return false;
 
     if (!lcmd_context->id.empty())
-      instance_id_map_.insert(std::make_pair(lcmd_context->id, cmd_context));
+      AddInstance(lcmd_context->id, cmd_context);
 
     lcmd_context->instance = std::move(cmd_context);
   }
@@ -1152,7 +1344,7 @@ bool Engine::CreateQueueSubmits(const Layout& layout) {
     lqueue_submit->instance = queue_submit;
 
     if (!lqueue_submit->id.empty())
-      instance_id_map_.insert(std::make_pair(lqueue_submit->id, queue_submit));
+      AddInstance(lqueue_submit->id, queue_submit);
 
     queue_submits_.emplace_back(std::move(queue_submit));
   }
@@ -1170,8 +1362,7 @@ bool Engine::CreateQueuePresents(const Layout& layout) {
     lqueue_present->instance = queue_present;
 
     if (!lqueue_present->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(lqueue_present->id, queue_present));
+      AddInstance(lqueue_present->id, queue_present);
 
     queue_presents_.emplace_back(std::move(queue_present));
   }
@@ -1187,7 +1378,7 @@ bool Engine::CreateOverlays(const Layout& layout) {
     if (!overlay) return false;
 
     if (!loverlay->id.empty())
-      instance_id_map_.insert(std::make_pair(loverlay->id, overlay));
+      AddInstance(loverlay->id, overlay);
 
     loverlay->instance = overlay;
 
@@ -1213,7 +1404,7 @@ bool Engine::CreateViewers(const Layout& layout) {
     if (!viewer) return false;
 
     if (!lwin_viewer->id.empty())
-      instance_id_map_.insert(std::make_pair(lwin_viewer->id, viewer));
+      AddInstance(lwin_viewer->id, viewer);
 
     lwin_viewer->instance = viewer;
 
@@ -1228,7 +1419,7 @@ bool Engine::CreateViewers(const Layout& layout) {
     if (!viewer) return false;
 
     if (!lreality_viewer->id.empty())
-      instance_id_map_.insert(std::make_pair(lreality_viewer->id, viewer));
+      AddInstance(lreality_viewer->id, viewer);
 
     lreality_viewer->instance = viewer;
 
@@ -1264,8 +1455,10 @@ void Engine::FinishResourceLoaders() {
     loader->Finish();
 
     const auto& limage = loader->GetInfo().limage;
-    if (limage->instance && !limage->id.empty())
+    if (limage->instance && !limage->id.empty()) {
+      std::lock_guard<std::mutex> lock(instance_id_mutex_);
       instance_id_map_.insert_or_assign(limage->id, limage->instance);
+    }
   }
   image_loaders_.clear();
 
@@ -1348,13 +1541,13 @@ bool Engine::Load(std::shared_ptr<Layout> layout) {
     auto& lwin = layout->lwindows[i];
 
     if (!lwin->id.empty())
-      instance_id_map_.insert(std::make_pair(lwin->id, win));
+      AddInstance(lwin->id, win);
 
     lwin->instance = win;
   }
 
   if (!layout->ldevice->id.empty())
-    instance_id_map_.insert(std::make_pair(layout->ldevice->id, device_));
+    AddInstance(layout->ldevice->id, device_);
 
   layout->ldevice->instance = device_;
 
@@ -1363,7 +1556,7 @@ bool Engine::Load(std::shared_ptr<Layout> layout) {
     if (i < layout->lqueues.size()) {
       auto& lqueue = layout->lqueues[i];
       if (!lqueue->id.empty())
-        instance_id_map_.insert(std::make_pair(lqueue->id, queue));
+        AddInstance(lqueue->id, queue);
 
       lqueue->instance = queue;
     }
@@ -1418,7 +1611,7 @@ bool Engine::CreateReality(const Layout& layout) {
   lsession->instance = session;
 
   if (!lsession->id.empty())
-    instance_id_map_.insert(std::make_pair(lsession->id, session));
+    AddInstance(lsession->id, session);
 
   return true;
 }
@@ -1435,8 +1628,7 @@ bool Engine::CreateReferenceSpace(const Layout& layout) {
     lreference_space->instance = reference_space;
 
     if (!lreference_space->id.empty())
-      instance_id_map_.insert(
-          std::make_pair(lreference_space->id, reference_space));
+      AddInstance(lreference_space->id, reference_space);
 
     reference_spaces_.emplace_back(std::move(reference_space));
   }
@@ -1453,7 +1645,7 @@ bool Engine::CreateCompositionLayerProjection(const Layout& layout) {
     lprojection->instance = projection;
 
     if (!lprojection->id.empty())
-      instance_id_map_.insert(std::make_pair(lprojection->id, projection));
+      AddInstance(lprojection->id, projection);
 
     composition_layer_projections_.emplace_back(std::move(projection));
   }
@@ -10,6 +10,7 @@
 #define XG_ENGINE_H_
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -81,6 +82,7 @@ class Engine {
   Engine& operator=(Engine&&) = delete;
 
   bool PostInit(const std::shared_ptr<Layout>& layout);
+  void AddInstance(const std::string& id, std::shared_ptr<void> instance);
   void AddSystemLayouts(Layout* layout);
   bool CreateRenderer(Layout* layout);
   bool CreateWindows(Layout* layout);
@@ -135,6 +137,7 @@ class Engine {
 
   std::shared_ptr<Renderer> renderer_;
   std::unordered_map<std::string, std::shared_ptr<void>> instance_id_map_;
+  std::mutex instance_id_mutex_;  // the init stages add concurrently
 
   std::vector<std::shared_ptr<Window>> windows_;
   std::shared_ptr<Device> device_;
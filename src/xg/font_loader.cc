@@ -18,6 +18,7 @@
 #include "xg/device.h"
 #include "xg/layout.h"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/overlay.h"
 #include "xg/resource_loader.h"
 #include "xg/thread_pool.h"
@@ -50,9 +51,11 @@ void FontLoader::Run(std::shared_ptr<Task> self) {
   auto overlay = static_cast<Overlay*>(loverlay->instance.get());
 
   for (const auto& font : loverlay->fonts) {
-    std::vector<uint8_t> font_data;
-    if (!LoadFile(font.first, &font_data)) return;
-    if (!overlay->AddFont(font_data, font.second)) return;
+    const auto file = MappedFile::Open(font.first);
+    if (!file) return;
+    if (!overlay->AddFont(file->GetData(), file->GetSize(), font.second)) {
+      return;
+    }
   }
 
   context_ = ResourceLoader::AcquireNextContext(self);
@@ -83,9 +86,7 @@ void FontLoader::Run(std::shared_ptr<Task> self) {
   result_ = 0;
 }
 
-void FontLoader::Finish() {
-  ResourceLoader::Finish();
-
+void FontLoader::OnFinished() {
   auto loverlay = info_.loverlay;
   auto overlay = static_cast<Overlay*>(loverlay->instance.get());
   overlay->DestroyFontUploadObjects();
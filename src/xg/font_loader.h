@@ -32,9 +32,10 @@ class FontLoader : public ResourceLoader {
  public:
   static std::shared_ptr<FontLoader> Load(const FontLoaderInfo& info);
   void Run(std::shared_ptr<Task> self) override;
-  void Finish() override;
 
  protected:
+  void OnFinished() override;
+
   FontLoaderInfo info_;
 };
 
@@ -19,6 +19,7 @@
 #include "xg/device.h"
 #include "xg/layout.h"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/resource_loader.h"
 #include "xg/thread_pool.h"
 #include "xg/types.h"
@@ -70,12 +71,12 @@ void ImageLoader::Run(std::shared_ptr<Task> self) {
   if (info_.src_ptr == nullptr) {
     assert(!info_.file_path.empty());
 
-    std::vector<uint8_t> file_data;
-    if (!LoadFile(info_.file_path, &file_data)) return;
+    const auto file = MappedFile::Open(info_.file_path);
+    if (!file) return;
 
     if (ends_with(info_.file_path, "ktx")) {
       auto result = ktxTexture_CreateFromMemory(
-          file_data.data(), file_data.size(),
+          file->GetData(), file->GetSize(),
           KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktx_texture);
       if (result != KTX_SUCCESS) {
         XG_ERROR("load ktx image fail: {} result: {}", info_.file_path, result);
@@ -106,7 +107,7 @@ void ImageLoader::Run(std::shared_ptr<Task> self) {
       int width, height, channels;
       int req_comp = FormatToSize(limage->format);
       info_.src_ptr = stbi_load_from_memory(
-          file_data.data(), static_cast<int>(file_data.size()), &width, &height,
+          file->GetData(), static_cast<int>(file->GetSize()), &width, &height,
           &channels, req_comp);
       if (!info_.src_ptr) {
         XG_ERROR("load stb image fail: {}", info_.file_path);
@@ -8,17 +8,30 @@
 
 #include "xg/layout.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <istream>
+#include <limits>
 #include <memory>
 #include <ostream>
+#include <stdexcept>
 #include <streambuf>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "SDL.h"
 #include "cereal/archives/binary.hpp"
 #include "cereal/types/polymorphic.hpp"
+#include "xg/asset_pack.h"
+#include "xg/layout_hash.h"
+#include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/utility.h"
+#include "zstd.h"
 
 CEREAL_REGISTER_TYPE(xg::LayoutEngine);
 CEREAL_REGISTER_TYPE(xg::LayoutConstant);
@@ -119,43 +132,386 @@ CEREAL_REGISTER_TYPE(xg::LayoutEndFrame);
 
 namespace xg {
 
-class CounterBuffer : public std::streambuf {
+static constexpr uint32_t kLayoutFileMagic = 0x5a4c4758;  // "XGLZ"
+static constexpr uint32_t kLayoutFileVersion = 5;
+
+static constexpr size_t kPageSize = 4096;
+static constexpr uint32_t kLayoutSectionCount =
+    static_cast<uint32_t>(LayoutSection::kData) + 1;
+
+// Precedes every archive, so that a file of another version, or one written
+// before there was a header, is rejected rather than misread.
+struct LayoutFileHeader {
+  uint32_t magic = kLayoutFileMagic;
+  uint32_t version = kLayoutFileVersion;
+  LayoutCodec codec = LayoutCodec::kNone;
+  uint32_t dict_id = 0;
+  uint32_t section_count = 0;  // of the table of a sectioned archive
+};
+
+// The table of contents of a sectioned layout, after the header. The sections
+// are contiguous but for the data section, which starts on a page boundary.
+struct LayoutSectionTable {
+  struct Entry {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  Entry entries[kLayoutSectionCount];
+
+  const Entry& operator[](LayoutSection section) const {
+    return entries[static_cast<uint32_t>(section)];
+  }
+  Entry& operator[](LayoutSection section) {
+    return entries[static_cast<uint32_t>(section)];
+  }
+
+  bool IsValid(size_t file_size) const {
+    uint64_t offset = sizeof(LayoutFileHeader) + sizeof(LayoutSectionTable);
+    for (const auto& entry : entries) {
+      if (entry.offset < offset || entry.size > file_size ||
+          entry.offset > file_size - entry.size) {
+        return false;
+      }
+      offset = entry.offset + entry.size;
+    }
+    return true;
+  }
+};
+
+static thread_local LayoutBlobSection* current_section = nullptr;
+
+LayoutBlobSection* LayoutBlobSection::GetCurrent() { return current_section; }
+
+LayoutBlobSection::Scope::Scope(LayoutBlobSection* section)
+    : previous_(current_section) {
+  current_section = section;
+}
+
+LayoutBlobSection::Scope::~Scope() { current_section = previous_; }
+
+static size_t Align(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+uint64_t LayoutBlobSection::Add(const LayoutBlob& blob) {
+  const auto offset = Align(size_, kAlignment);
+  size_ = offset + blob.GetSize();
+  blobs_.emplace_back(&blob);
+  return offset;
+}
+
+bool LayoutBlobSection::Map(uint64_t offset, uint64_t size,
+                            LayoutBlob* blob) const {
+  assert(file_ || filepath_);
+  if (offset > size_ || size > size_ - offset) {
+    XG_ERROR("blob out of range: {} + {} > {}", offset, size, size_);
+    return false;
+  }
+
+  blob->mapped_file = file_;
+  blob->deferred_file = filepath_;
+  blob->mapped_offset = offset_ + static_cast<size_t>(offset);
+  blob->mapped_size = static_cast<size_t>(size);
+  return true;
+}
+
+// Only the blobs of a layout outside the asset packs are deferred, the
+// reader maps those of a packed layout.
+bool LayoutBlob::Load() const {
+  std::call_once(load_flag_, [this]() {
+    bytes.resize(mapped_size);
+
+    auto* rw = SDL_RWFromFile(deferred_file->c_str(), "rb");
+    if (!rw) {
+      XG_ERROR("failed to open file: {}, error: {}", *deferred_file,
+               SDL_GetError());
+      load_failed_ = true;
+    } else {
+      if (SDL_RWseek(rw, static_cast<Sint64>(mapped_offset), RW_SEEK_SET) < 0 ||
+          (mapped_size > 0 &&
+           SDL_RWread(rw, bytes.data(), mapped_size, 1) != 1)) {
+        XG_ERROR("failed to read file: {}", *deferred_file);
+        load_failed_ = true;
+      }
+      SDL_RWclose(rw);
+    }
+    if (load_failed_) std::vector<uint8_t>().swap(bytes);
+    loaded_ = true;
+  });
+  return !load_failed_;
+}
+
+// Writes to a file through a fixed size buffer, compressing with zstd once
+// a compression context is set. Writes larger than the buffer, such as data
+// blobs, skip the buffer.
+class FileStreamBuffer : public std::streambuf {
  public:
-  size_t GetSize(void) const { return size_; }
+  explicit FileStreamBuffer(SDL_RWops* rw) : rw_(rw) {
+    setp(buffer_, buffer_ + sizeof(buffer_));
+  }
+
+  ~FileStreamBuffer() override {
+    if (cctx_) ZSTD_freeCCtx(cctx_);
+  }
+
+  bool SetCompression(const LayoutSerializeInfo& info) {
+    cctx_ = ZSTD_createCCtx();
+    if (!cctx_) {
+      XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+      return false;
+    }
+    compressed_.resize(ZSTD_CStreamOutSize());
+
+    if (!CheckZstd(ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel,
+                                          info.level))) {
+      return false;
+    }
+
+    const auto worker_count =
+        info.worker_count > 0
+            ? info.worker_count
+            : static_cast<int>(std::thread::hardware_concurrency());
+    const auto result =
+        ZSTD_CCtx_setParameter(cctx_, ZSTD_c_nbWorkers, worker_count);
+    if (ZSTD_isError(result)) {
+      XG_WARN("zstd multithreading unavailable: {}",
+              ZSTD_getErrorName(result));
+    }
+
+    if (info.dictionary) {
+      const auto& dictionary = *info.dictionary;
+      return CheckZstd(ZSTD_CCtx_loadDictionary(cctx_, dictionary.data(),
+                                                dictionary.size()));
+    }
+    return true;
+  }
+
+  // Writes out what is buffered and ends the compressed frame.
+  bool Finish() {
+    if (!Flush()) return false;
+    return !cctx_ || Compress(nullptr, 0, ZSTD_e_end);
+  }
+
+  bool IsError() const { return error_; }
+
+  // The file position of the next byte, uncompressed only.
+  uint64_t Tell() {
+    assert(!cctx_);
+    return Flush() ? static_cast<uint64_t>(SDL_RWtell(rw_)) : 0;
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!Flush()) return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    if (n > epptr() - pptr()) {
+      if (!Flush()) return 0;
+      if (n >= static_cast<std::streamsize>(sizeof(buffer_))) {
+        return Write(s, static_cast<size_t>(n)) ? n : 0;
+      }
+    }
+    std::memcpy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+  }
+
+  int sync() override { return Flush() ? 0 : -1; }
 
  private:
-  int_type overflow(int_type c) { return static_cast<int_type>(size_++); }
-  size_t size_ = 0;
-};
+  bool CheckZstd(size_t result) {
+    if (!ZSTD_isError(result)) return true;
+    XG_ERROR("zstd error: {}", ZSTD_getErrorName(result));
+    error_ = true;
+    return false;
+  }
 
-template <typename char_type>
-struct OutStreamBuffer
-    : public std::basic_streambuf<char_type, std::char_traits<char_type>> {
-  OutStreamBuffer(char_type* buf, std::streamsize len) {
-    std::basic_streambuf<char_type, std::char_traits<char_type>>::setp(
-        buf, buf + len);
+  bool WriteFile(const void* data, size_t size) {
+    if (!error_ && SDL_RWwrite(rw_, data, 1, size) != size) error_ = true;
+    return !error_;
   }
+
+  bool Compress(const char* data, size_t size, ZSTD_EndDirective mode) {
+    ZSTD_inBuffer in = {data, size, 0};
+    size_t remaining = 0;
+
+    do {
+      ZSTD_outBuffer out = {compressed_.data(), compressed_.size(), 0};
+      remaining = ZSTD_compressStream2(cctx_, &out, &in, mode);
+      if (!CheckZstd(remaining) || !WriteFile(out.dst, out.pos)) return false;
+    } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+
+    return true;
+  }
+
+  bool Write(const char* data, size_t size) {
+    if (error_) return false;
+    if (cctx_) return Compress(data, size, ZSTD_e_continue);
+    return WriteFile(data, size);
+  }
+
+  bool Flush() {
+    const auto size = static_cast<size_t>(pptr() - pbase());
+    setp(buffer_, buffer_ + sizeof(buffer_));
+    return size == 0 || Write(buffer_, size);
+  }
+
+  SDL_RWops* rw_;
+  char buffer_[64 * 1024];
+  ZSTD_CCtx* cctx_ = nullptr;
+  std::vector<char> compressed_;
+  bool error_ = false;
 };
 
-bool Layout::Serialize(const std::string& filepath) {
-  CounterBuffer counter_buffer;
-  std::basic_ostream<char> counter_stream(&counter_buffer);
-  cereal::BinaryOutputArchive counter_archive(counter_stream);
-  counter_archive(shared_from_this());
+using LayoutSectionIds = std::vector<std::shared_ptr<LayoutBase>>;
+
+// Finds the nodes with an id in the section that cereal archives them in,
+// the first one that refers to them, by following the references the way
+// the archive does.
+static std::vector<LayoutSectionIds> CollectSectionIds(Layout* layout) {
+  std::unordered_map<const LayoutBase*, std::shared_ptr<LayoutBase>> named;
+  for (const auto& mapping : layout->node_id_map) {
+    named.emplace(mapping.second.get(), mapping.second);
+  }
+
+  // the blobs are only counted, rather than hashed
+  LayoutBlobSection blob_section;
+  LayoutBlobSection::Scope scope(&blob_section);
+
+  std::vector<LayoutSectionIds> section_ids(kLayoutSectionCount - 1);
+  std::unordered_set<const LayoutBase*> visited;
+  for (uint32_t i = 0; i < kLayoutSectionCount - 1; ++i) {
+    LayoutHashArchive roots;
+    layout->SerializeSection(roots, static_cast<LayoutSection>(i));
+    auto pending = roots.TakeReferences();
+
+    while (!pending.empty()) {
+      const auto node = pending.back();
+      pending.pop_back();
+      if (!visited.insert(node).second) continue;
+
+      const auto it = named.find(node);
+      if (it != named.end()) {
+        section_ids[i].emplace_back(it->second);
+        named.erase(it);
+      }
+
+      LayoutHashArchive archive;
+      archive.AddNode(node);
+      const auto references = archive.TakeReferences();
+      pending.insert(pending.end(), references.begin(), references.end());
+    }
+  }
+
+  // not referred to by any section, so archived with the last one
+  for (const auto& mapping : layout->node_id_map) {
+    if (named.count(mapping.second.get())) {
+      section_ids[kLayoutSectionCount - 2].emplace_back(mapping.second);
+    }
+  }
+  return section_ids;
+}
+
+static void LoadSectionIds(cereal::BinaryInputArchive& archive,
+                           Layout* layout) {
+  LayoutSectionIds nodes;
+  archive(nodes);
+  for (auto& node : nodes) {
+    if (node) layout->node_id_map.emplace(node->id, std::move(node));
+  }
+}
+
+// The archive is written in a single pass, without a copy in memory.
+bool Layout::Serialize(const std::string& filepath,
+                       const LayoutSerializeInfo& info) {
+  auto* rw = SDL_RWFromFile(filepath.c_str(), "wb");
+  if (!rw) {
+    XG_ERROR("failed to open file: {}, error: {}", filepath, SDL_GetError());
+    return false;
+  }
+
+  FileStreamBuffer stream_buffer(rw);
+  LayoutFileHeader header;
+  LayoutSectionTable table;
+  bool result = true;
+
+  if (info.sectioned && info.codec != LayoutCodec::kNone) {
+    XG_ERROR("sectioned layouts cannot be compressed");
+    result = false;
+  } else if (info.codec == LayoutCodec::kZstd) {
+    header.codec = info.codec;
+    if (info.dictionary) {
+      header.dict_id = ZSTD_getDictID_fromDict(info.dictionary->data(),
+                                               info.dictionary->size());
+    }
+    result = SDL_RWwrite(rw, &header, sizeof(header), 1) == 1 &&
+             stream_buffer.SetCompression(info);
+  } else if (info.sectioned) {
+    header.section_count = kLayoutSectionCount;
+    result = SDL_RWwrite(rw, &header, sizeof(header), 1) == 1 &&
+             SDL_RWwrite(rw, &table, sizeof(table), 1) == 1;
+  } else {
+    result = SDL_RWwrite(rw, &header, sizeof(header), 1) == 1;
+  }
+
+  LayoutBlobSection blob_section;
+  if (result) {
+    std::ostream stream(&stream_buffer);
+    cereal::BinaryOutputArchive archive(stream);
 
-  size_t size = counter_buffer.GetSize();
+    if (info.sectioned) {
+      const auto section_ids = CollectSectionIds(this);
+      LayoutBlobSection::Scope scope(&blob_section);
+      for (uint32_t i = 0; i < kLayoutSectionCount - 1; ++i) {
+        const auto section = static_cast<LayoutSection>(i);
+        table[section].offset = stream_buffer.Tell();
+        SerializeSection(archive, section);
+        archive(section_ids[i]);
+        table[section].size = stream_buffer.Tell() - table[section].offset;
+      }
+    } else {
+      archive(shared_from_this());
+    }
+    result = stream_buffer.Finish();
+  }
 
-  std::vector<uint8_t> data;
-  data.resize(size);
+  // the blobs follow the archive, at the offsets it refers to
+  if (result && info.sectioned) {
+    static const char zeros[kPageSize] = {};
+    const auto write = [rw](const void* data, size_t size) {
+      return size == 0 || SDL_RWwrite(rw, data, size, 1) == 1;
+    };
 
-  OutStreamBuffer<char> stream_buffer(reinterpret_cast<char*>(data.data()),
-                                      size);
-  std::ostream stream(&stream_buffer);
+    const auto archive_end = static_cast<size_t>(SDL_RWtell(rw));
+    auto& data = table[LayoutSection::kData];
+    data.offset = Align(archive_end, kPageSize);
+    result = write(zeros, data.offset - archive_end);
 
-  cereal::BinaryOutputArchive archive(stream);
-  archive(shared_from_this());
+    size_t position = 0;
+    for (const auto blob : blob_section.GetBlobs()) {
+      if (!result) break;
+      const auto offset = Align(position, LayoutBlobSection::kAlignment);
+      result = write(zeros, offset - position) &&
+               write(blob->GetData(), blob->GetSize());
+      position = offset + blob->GetSize();
+    }
+    data.size = position;
 
-  if (!SaveFile(filepath, data)) return false;
+    result = result && SDL_RWseek(rw, sizeof(header), RW_SEEK_SET) >= 0 &&
+             write(&table, sizeof(table));
+  }
+
+  if (SDL_RWclose(rw) != 0 || !result) {
+    XG_ERROR("failed to write file: {}", filepath);
+    return false;
+  }
 
   return true;
 }
@@ -173,17 +529,332 @@ struct InStream : virtual InStreamBuffer, std::istream {
         std::istream(static_cast<std::streambuf*>(this)) {}
 };
 
-std::shared_ptr<Layout> Layout::Deserialize(const std::string& filepath) {
-  std::vector<uint8_t> data;
-  if (!LoadFile(filepath, &data)) return nullptr;
+// Runs |decode|, which reports a truncated or corrupted archive by throwing
+// a cereal::Exception, or a std::bad_alloc or std::length_error for a size
+// read from it.
+template <typename Decode>
+static bool DecodeArchive(const std::string& filepath, Decode&& decode) {
+  try {
+    decode();
+    return true;
+  } catch (const std::exception& e) {
+    XG_ERROR("corrupted layout file: {}, error: {}", filepath, e.what());
+    return false;
+  }
+}
+
+// Decompresses a mapped zstd stream as it is read. Reads larger than the
+// buffer, such as data blobs, are decompressed straight into the reader.
+class ZstdInStreamBuffer : public std::streambuf {
+ public:
+  ZstdInStreamBuffer(ZSTD_DCtx* dctx, const uint8_t* data, size_t size)
+      : dctx_(dctx), in_{data, size, 0} {}
+
+ protected:
+  int_type underflow() override {
+    if (gptr() == egptr()) {
+      const auto size = Decompress(buffer_, sizeof(buffer_));
+      if (size == 0) return traits_type::eof();
+      setg(buffer_, buffer_, buffer_ + size);
+    }
+    return traits_type::to_int_type(*gptr());
+  }
+
+  std::streamsize xsgetn(char* s, std::streamsize n) override {
+    std::streamsize count = 0;
+
+    while (count < n) {
+      if (gptr() == egptr() &&
+          n - count >= static_cast<std::streamsize>(sizeof(buffer_))) {
+        const auto size = Decompress(s + count, static_cast<size_t>(n - count));
+        if (size == 0) break;
+        count += static_cast<std::streamsize>(size);
+        continue;
+      }
+      if (traits_type::eq_int_type(underflow(), traits_type::eof())) break;
+
+      const auto size = std::min(n - count, egptr() - gptr());
+      std::memcpy(s + count, gptr(), static_cast<size_t>(size));
+      gbump(static_cast<int>(size));
+      count += size;
+    }
+    return count;
+  }
+
+ private:
+  // Returns 0 at the end of the stream or on an error.
+  size_t Decompress(char* dst, size_t size) {
+    ZSTD_outBuffer out = {dst, size, 0};
+
+    while (out.pos == 0) {
+      const auto last_pos = in_.pos;
+      const auto result = ZSTD_decompressStream(dctx_, &out, &in_);
+      if (ZSTD_isError(result)) {
+        XG_ERROR("zstd error: {}", ZSTD_getErrorName(result));
+        return 0;
+      }
+      if (out.pos == 0 && in_.pos == last_pos) {
+        if (!frame_ended_) XG_ERROR("truncated compressed layout");
+        return 0;
+      }
+      frame_ended_ = result == 0;
+    }
+    return out.pos;
+  }
+
+  ZSTD_DCtx* dctx_;
+  ZSTD_inBuffer in_;
+  bool frame_ended_ = false;
+  char buffer_[64 * 1024];
+};
+
+static std::shared_ptr<Layout> DeserializeZstd(
+    const std::string& filepath, const MappedFile& file,
+    const LayoutFileHeader& header, const std::vector<uint8_t>* dictionary) {
+  if (header.dict_id != 0 &&
+      (!dictionary || ZSTD_getDictID_fromDict(dictionary->data(),
+                                              dictionary->size()) !=
+                          header.dict_id)) {
+    XG_ERROR("layout needs zstd dictionary: {}", header.dict_id);
+    return nullptr;
+  }
+
+  const std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(
+      ZSTD_createDCtx(), ZSTD_freeDCtx);
+  if (!dctx) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  if (dictionary) {
+    const auto result = ZSTD_DCtx_loadDictionary(
+        dctx.get(), dictionary->data(), dictionary->size());
+    if (ZSTD_isError(result)) {
+      XG_ERROR("zstd error: {}", ZSTD_getErrorName(result));
+      return nullptr;
+    }
+  }
+
+  ZstdInStreamBuffer stream_buffer(dctx.get(), file.GetData() + sizeof(header),
+                                   file.GetSize() - sizeof(header));
+  std::istream stream(&stream_buffer);
+
+  std::shared_ptr<xg::Layout> layout;
+  const auto result = DecodeArchive(filepath, [&stream, &layout]() {
+    cereal::BinaryInputArchive archive(stream);
+    archive(layout);
+  });
+
+  return result ? layout : nullptr;
+}
+
+// The archive of a sectioned layout keeps the file mapped through its blobs.
+static std::shared_ptr<Layout> DeserializeSectioned(
+    const std::string& filepath, std::shared_ptr<MappedFile> file,
+    const LayoutSectionTable& table) {
+  const auto& first = table[LayoutSection::kDevice];
+  const auto& last = table[LayoutSection::kCommands];
+  InStream stream(reinterpret_cast<const char*>(file->GetData()) + first.offset,
+                  static_cast<size_t>(last.offset + last.size - first.offset));
+
+  const auto& data = table[LayoutSection::kData];
+  LayoutBlobSection section(file, static_cast<size_t>(data.offset));
+  LayoutBlobSection::Scope scope(&section);
+  auto layout = std::make_shared<Layout>();
+  const auto result = DecodeArchive(filepath, [&stream, &layout]() {
+    cereal::BinaryInputArchive archive(stream);
+    for (uint32_t i = 0; i < kLayoutSectionCount - 1; ++i) {
+      layout->SerializeSection(archive, static_cast<LayoutSection>(i));
+      LoadSectionIds(archive, layout.get());
+    }
+  });
+
+  return result ? layout : nullptr;
+}
+
+std::shared_ptr<Layout> Layout::Deserialize(
+    const std::string& filepath, const std::vector<uint8_t>* dictionary) {
+  const auto file = MappedFile::Open(filepath);
+  if (!file) return nullptr;
+
+  LayoutFileHeader header;
+  header.magic = 0;
+  if (file->GetSize() >= sizeof(header)) {
+    std::memcpy(&header, file->GetData(), sizeof(header));
+  }
+
+  // the files written before the header cannot be told apart from garbage,
+  // they need to be written again
+  if (header.magic != kLayoutFileMagic ||
+      header.version != kLayoutFileVersion) {
+    XG_ERROR("unsupported layout file version: {}", filepath);
+    return nullptr;
+  }
+
+  if (header.codec == LayoutCodec::kZstd && header.section_count == 0) {
+    return DeserializeZstd(filepath, *file, header, dictionary);
+  }
+
+  if (header.codec != LayoutCodec::kNone) {
+    XG_ERROR("unsupported layout file: {}", filepath);
+    return nullptr;
+  }
 
-  InStream stream(reinterpret_cast<char*>(data.data()), data.size());
+  if (header.section_count != 0) {
+    LayoutSectionTable table;
+    if (header.section_count == kLayoutSectionCount &&
+        file->GetSize() >= sizeof(header) + sizeof(table)) {
+      std::memcpy(&table, file->GetData() + sizeof(header), sizeof(table));
+    }
+    if (!table.IsValid(file->GetSize())) {
+      XG_ERROR("unsupported layout file: {}", filepath);
+      return nullptr;
+    }
+    return DeserializeSectioned(filepath, file, table);
+  }
+
+  InStream stream(reinterpret_cast<const char*>(file->GetData()) +
+                      sizeof(header),
+                  file->GetSize() - sizeof(header));
 
-  cereal::BinaryInputArchive archive(stream);
   std::shared_ptr<xg::Layout> layout;
-  archive(layout);
+  const auto result = DecodeArchive(filepath, [&stream, &layout]() {
+    cereal::BinaryInputArchive archive(stream);
+    archive(layout);
+  });
+
+  return result ? layout : nullptr;
+}
+
+// Reads the node sections of a sectioned layout through a fixed size buffer.
+class LayoutInStreamBuffer : public std::streambuf {
+ public:
+  LayoutInStreamBuffer(SDL_RWops* rw, uint64_t offset, uint64_t end)
+      : rw_(rw), position_(offset), end_(end) {}
+
+  ~LayoutInStreamBuffer() override { SDL_RWclose(rw_); }
+
+  // The file position of the next byte.
+  uint64_t Tell() const {
+    return position_ - static_cast<uint64_t>(egptr() - gptr());
+  }
+
+ protected:
+  int_type underflow() override {
+    if (gptr() == egptr()) {
+      const auto size = static_cast<size_t>(
+          std::min<uint64_t>(sizeof(buffer_), end_ - position_));
+      if (size == 0 || SDL_RWread(rw_, buffer_, size, 1) != 1) {
+        return traits_type::eof();
+      }
+      position_ += size;
+      setg(buffer_, buffer_, buffer_ + size);
+    }
+    return traits_type::to_int_type(*gptr());
+  }
 
-  return layout;
+ private:
+  SDL_RWops* rw_;
+  uint64_t position_;
+  uint64_t end_;
+  char buffer_[64 * 1024];
+};
+
+std::unique_ptr<LayoutReader> LayoutReader::Open(const std::string& filepath) {
+  // an entry of an asset pack is in memory already, so its blobs are used
+  // from it rather than read on use
+  const auto packed_file = AssetPackRegistry::Get().Find(filepath);
+  SDL_RWops* rw = nullptr;
+  if (!packed_file) {
+    rw = SDL_RWFromFile(filepath.c_str(), "rb");
+  } else if (packed_file->GetSize() <= std::numeric_limits<int>::max()) {
+    rw = SDL_RWFromConstMem(packed_file->GetData(),
+                            static_cast<int>(packed_file->GetSize()));
+  }
+  if (!rw) {
+    XG_ERROR("failed to open file: {}, error: {}", filepath, SDL_GetError());
+    return nullptr;
+  }
+
+  const auto file_size = SDL_RWsize(rw);
+  LayoutFileHeader header;
+  LayoutSectionTable table;
+  if (file_size < 0 ||
+      SDL_RWread(rw, &header, sizeof(header), 1) != 1 ||
+      SDL_RWread(rw, &table, sizeof(table), 1) != 1 ||
+      header.magic != kLayoutFileMagic ||
+      header.version != kLayoutFileVersion ||
+      header.codec != LayoutCodec::kNone ||
+      header.section_count != kLayoutSectionCount ||
+      !table.IsValid(static_cast<size_t>(file_size))) {
+    XG_ERROR("not a sectioned layout file: {}", filepath);
+    SDL_RWclose(rw);
+    return nullptr;
+  }
+
+  const auto& first = table[LayoutSection::kDevice];
+  const auto& last = table[LayoutSection::kCommands];
+  if (SDL_RWseek(rw, static_cast<Sint64>(first.offset), RW_SEEK_SET) < 0) {
+    XG_ERROR("failed to read file: {}", filepath);
+    SDL_RWclose(rw);
+    return nullptr;
+  }
+
+  std::unique_ptr<LayoutReader> reader(new LayoutReader());
+  reader->filepath_ = std::make_shared<const std::string>(filepath);
+  reader->packed_file_ = packed_file;
+  for (const auto& entry : table.entries) {
+    reader->sections_.emplace_back(SectionEntry{entry.offset, entry.size});
+  }
+  reader->stream_buffer_ = std::make_unique<LayoutInStreamBuffer>(
+      rw, first.offset, last.offset + last.size);
+  reader->stream_ = std::make_unique<std::istream>(reader->stream_buffer_.get());
+  reader->archive_ =
+      std::make_unique<cereal::BinaryInputArchive>(*reader->stream_);
+
+  const auto& data = table[LayoutSection::kData];
+  if (packed_file) {
+    reader->blob_section_ = std::make_unique<LayoutBlobSection>(
+        packed_file, static_cast<size_t>(data.offset));
+  } else {
+    reader->blob_section_ = std::make_unique<LayoutBlobSection>(
+        reader->filepath_, static_cast<size_t>(data.offset),
+        static_cast<size_t>(data.size));
+  }
+  reader->layout_ = std::make_shared<Layout>();
+
+  return reader;
+}
+
+LayoutReader::~LayoutReader() = default;
+
+bool LayoutReader::Load(LayoutSection section) {
+  // the stream is left in the middle of a section by a failure
+  if (failed_) return false;
+
+  // the blobs are read on use, so the data section needs no decoding
+  const auto count = std::min(static_cast<uint32_t>(section) + 1,
+                              kLayoutSectionCount - 1);
+  LayoutBlobSection::Scope scope(blob_section_.get());
+
+  for (; loaded_count_ < count; ++loaded_count_) {
+    const auto& entry = sections_[loaded_count_];
+    failed_ = !DecodeArchive(*filepath_, [this]() {
+      layout_->SerializeSection(*archive_,
+                                static_cast<LayoutSection>(loaded_count_));
+      LoadSectionIds(*archive_, layout_.get());
+    });
+    if (failed_) return false;
+
+    if (stream_buffer_->Tell() != entry.offset + entry.size) {
+      XG_ERROR("corrupted layout section {}: {}", loaded_count_, *filepath_);
+      failed_ = true;
+      return false;
+    }
+  }
+  if (section == LayoutSection::kData) loaded_count_ = kLayoutSectionCount;
+
+  return true;
 }
 
 }  // namespace xg
@@ -10,10 +10,13 @@
 #define XG_LAYOUT_H_
 
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <istream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -30,6 +33,7 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/types.h"
 
 namespace std {
@@ -249,6 +253,120 @@ enum class LayoutType {
 #endif  // XG_ENABLE_REALITY
 };
 
+struct LayoutBlob;
+
+// The blobs of a sectioned layout file are stored after the archive,
+// aligned, and the archive refers to them by offset. While a section is
+// current on a thread, blobs are archived that way and loaded either as spans
+// of the mapped file or, for a layout read in sections, read from the file on
+// use.
+class LayoutBlobSection {
+ public:
+  static constexpr size_t kAlignment = 16;
+
+  static LayoutBlobSection* GetCurrent();
+
+  LayoutBlobSection() = default;
+  LayoutBlobSection(std::shared_ptr<MappedFile> file, size_t offset)
+      : file_(std::move(file)),
+        offset_(offset),
+        size_(file_->GetSize() - offset) {}
+  LayoutBlobSection(std::shared_ptr<const std::string> filepath, size_t offset,
+                    size_t size)
+      : filepath_(std::move(filepath)), offset_(offset), size_(size) {}
+
+  // Returns the offset of |blob| in the section, which is written later.
+  uint64_t Add(const LayoutBlob& blob);
+  bool Map(uint64_t offset, uint64_t size, LayoutBlob* blob) const;
+
+  const std::vector<const LayoutBlob*>& GetBlobs() const { return blobs_; }
+
+  // Makes a section current on this thread for the lifetime of the scope.
+  class Scope {
+   public:
+    explicit Scope(LayoutBlobSection* section);
+    ~Scope();
+
+   private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    LayoutBlobSection* previous_;
+  };
+
+ private:
+  LayoutBlobSection(const LayoutBlobSection&) = delete;
+  LayoutBlobSection& operator=(const LayoutBlobSection&) = delete;
+
+  std::shared_ptr<MappedFile> file_;
+  std::shared_ptr<const std::string> filepath_;
+  size_t offset_ = 0;
+  size_t size_ = 0;
+  std::vector<const LayoutBlob*> blobs_;
+};
+
+// Immutable bytes, either owned, a span of a mapped file or a deferred span
+// of a file, which is read on first use. The nodes with the same content
+// share a blob, which cereal then writes once per archive.
+struct LayoutBlob {
+  LayoutBlob() = default;
+  explicit LayoutBlob(std::vector<uint8_t> data) : bytes(std::move(data)) {}
+  explicit LayoutBlob(std::shared_ptr<MappedFile> file)
+      : mapped_file(std::move(file)), mapped_size(mapped_file->GetSize()) {}
+
+  // Returns nullptr if a deferred blob cannot be read, as it may for an
+  // empty blob.
+  const uint8_t* GetData() const {
+    if (mapped_file) return mapped_file->GetData() + mapped_offset;
+    if (deferred_file && !Load()) return nullptr;
+    return bytes.data();
+  }
+  size_t GetSize() const {
+    return mapped_file || deferred_file ? mapped_size : bytes.size();
+  }
+  bool IsDeferred() const { return deferred_file && !loaded_; }
+
+  // written in the same format as the bytes vector
+  template <class Archive>
+  void save(Archive& archive) const {
+    const auto section = LayoutBlobSection::GetCurrent();
+    if (section) {
+      archive(section->Add(*this), static_cast<uint64_t>(GetSize()));
+      return;
+    }
+    archive(cereal::make_size_tag(static_cast<cereal::size_type>(GetSize())),
+            cereal::binary_data(GetData(), GetSize()));
+  }
+
+  template <class Archive>
+  void load(Archive& archive) {
+    const auto section = LayoutBlobSection::GetCurrent();
+    if (section) {
+      uint64_t offset = 0;
+      uint64_t size = 0;
+      archive(offset, size);
+      if (!section->Map(offset, size, this)) {
+        throw cereal::Exception("layout blob out of range");
+      }
+      return;
+    }
+    archive(bytes);
+  }
+
+  mutable std::vector<uint8_t> bytes;
+  std::shared_ptr<MappedFile> mapped_file;
+  std::shared_ptr<const std::string> deferred_file;
+  size_t mapped_offset = 0;
+  size_t mapped_size = 0;
+
+ private:
+  bool Load() const;
+
+  mutable std::once_flag load_flag_;
+  mutable std::atomic<bool> loaded_{false};
+  mutable bool load_failed_ = false;
+};
+
 struct LayoutBase {
   LayoutBase() = default;
   LayoutBase(LayoutType ltype) : layout_type(ltype) {}
@@ -289,12 +407,17 @@ struct LayoutConstant : LayoutBase {
 struct LayoutData : LayoutBase {
   LayoutData() : LayoutBase{LayoutType::kData} {}
 
-  std::vector<uint8_t> data;
+  std::shared_ptr<LayoutBlob> data = std::make_shared<LayoutBlob>();
+  std::string file;
+  size_t offset = 0;
+  size_t size = static_cast<size_t>(-1);
 
   template <class Archive>
   void serialize(Archive& archive) {
-    archive(cereal::base_class<LayoutBase>(this), data);
+    archive(cereal::base_class<LayoutBase>(this), data, file, offset, size);
   }
+
+  std::shared_ptr<MappedFile> mapped_file;
 };
 
 struct LayoutResourceLoader : LayoutBase {
@@ -452,6 +575,7 @@ struct LayoutBufferLoader : LayoutBase {
   }
 
   const void* data = nullptr;
+  size_t data_size = 0;
   const char* lbuffer_id = nullptr;
   const char* lqueue_id = nullptr;
   const char* ldata_id = nullptr;
@@ -698,7 +822,7 @@ struct LayoutDependency : LayoutBase {
 struct LayoutShaderModule : LayoutBase {
   LayoutShaderModule() : LayoutBase{LayoutType::kShaderModule} {}
 
-  std::vector<uint8_t> code;
+  std::shared_ptr<LayoutBlob> code = std::make_shared<LayoutBlob>();
 
   template <class Archive>
   void serialize(Archive& archive) {
@@ -2044,6 +2168,29 @@ struct LayoutEndFrame : LayoutBase {
 
 #endif  // XG_ENABLE_REALITY
 
+enum class LayoutCodec : uint32_t { kNone, kZstd };
+
+// The sections of a sectioned layout file, in file order. The data section
+// holds the blobs.
+enum class LayoutSection : uint32_t {
+  kDevice,
+  kResources,
+  kPipelines,
+  kCommands,
+  kData,
+};
+
+struct LayoutSerializeInfo {
+  LayoutCodec codec = LayoutCodec::kNone;
+  int level = 3;
+  int worker_count = 0;  // compression threads, 0 for one per core
+  const std::vector<uint8_t>* dictionary = nullptr;
+  // Written in sections, which LayoutReader loads on demand, and with the
+  // blobs used from the mapped file instead of copied, uncompressed only.
+  // The nodes are decoded through cereal all the same.
+  bool sectioned = false;
+};
+
 struct Layout : std::enable_shared_from_this<Layout> {
   std::shared_ptr<LayoutResourceLoader> lres_loader;
   std::shared_ptr<LayoutRenderer> lrenderer;
@@ -2128,79 +2275,155 @@ struct Layout : std::enable_shared_from_this<Layout> {
 
   template <class Archive>
   void serialize(Archive& archive) {
-    archive(lres_loader);
-    archive(lrenderer);
-    archive(lwindows);
-    archive(ldevice);
-    archive(lqueues);
-    archive(lcmd_pools);
-    archive(lcmd_buffers);
-    archive(lfences);
-    archive(lbuffers);
-    archive(lbuffer_loaders);
-    archive(limages);
-    archive(limage_loaders);
-    archive(limage_views);
-    archive(lrender_passes);
-    archive(lcolor_attachments);
-    archive(ldepth_stencil_attachments);
-    archive(ldependencies);
-    archive(lshader_modules);
-    archive(ldesc_set_layouts);
-    archive(lpipeline_layouts);
-    archive(lcompute_pipelines);
-    archive(lgraphics_pipelines);
-    archive(lswapchains);
-    archive(ldesc_pools);
-    archive(ldesc_sets);
-    archive(ldescriptors);
-    archive(ldesc_image_infos);
-    archive(ldesc_buffer_infos);
-    archive(lframes);
-    archive(lframebuffers);
-    archive(lsemaphores);
-    archive(lsamplers);
-    archive(lquery_pools);
-    archive(levents);
-    archive(lcameras);
-    archive(lcmd_groups);
-    archive(lcmd_lists);
-    archive(lcmd_contexts);
-    archive(lfunctions);
-    archive(lbuffer_memory_barriers);
-    archive(limage_memory_barriers);
-    archive(lcopy_buffers);
-    archive(lbegin_render_passes);
-    archive(lbind_desc_sets);
-    archive(lbind_pipelines);
-    archive(lbind_vertex_buffers);
-    archive(lbind_index_buffers);
-    archive(ldraw_indexed_indirects);
-    archive(lblit_images);
-    archive(lpush_constants);
-    archive(lreset_query_pools);
-    archive(lset_events);
-    archive(lreset_events);
-    archive(ldraw_overlays);
-    archive(loverlays);
-    archive(lwindow_viewers);
-    archive(lqueue_submits);
-    archive(lqueue_presents);
-
-#ifdef XG_ENABLE_REALITY
-    archive(lreality);
-    archive(lsession);
-    archive(lreference_spaces);
-    archive(lcomposition_layer_projections);
-    archive(lreality_viewers);
-#endif  // XG_ENABLE_REALITY
-
-    archive(lnodes);
+    SerializeSection(archive, LayoutSection::kDevice);
+    SerializeSection(archive, LayoutSection::kResources);
+    SerializeSection(archive, LayoutSection::kPipelines);
+    SerializeSection(archive, LayoutSection::kCommands);
     archive(node_id_map);
   }
 
-  bool Serialize(const std::string& filepath);
-  static std::shared_ptr<Layout> Deserialize(const std::string& filepath);
+  // A node is archived in the first section that refers to it, which is not
+  // necessarily the section of its type, so a section may only be loaded
+  // after the sections before it. In a sectioned layout, each section is
+  // followed by the nodes with an id that it archived.
+  template <class Archive>
+  void SerializeSection(Archive& archive, LayoutSection section) {
+    switch (section) {
+      case LayoutSection::kDevice:
+        archive(lres_loader);
+        archive(lrenderer);
+        archive(lwindows);
+        archive(ldevice);
+        archive(lqueues);
+        archive(lcmd_pools);
+        archive(lcmd_buffers);
+        archive(lfences);
+        archive(lswapchains);
+        archive(lframes);
+        archive(lsemaphores);
+#ifdef XG_ENABLE_REALITY
+        archive(lreality);
+        archive(lsession);
+        archive(lreference_spaces);
+#endif  // XG_ENABLE_REALITY
+        break;
+
+      case LayoutSection::kResources:
+        archive(lbuffers);
+        archive(lbuffer_loaders);
+        archive(limages);
+        archive(limage_loaders);
+        archive(limage_views);
+        archive(lsamplers);
+        archive(ldesc_pools);
+        archive(ldesc_sets);
+        archive(ldescriptors);
+        archive(ldesc_image_infos);
+        archive(ldesc_buffer_infos);
+        archive(lquery_pools);
+        archive(levents);
+        break;
+
+      case LayoutSection::kPipelines:
+        archive(lrender_passes);
+        archive(lcolor_attachments);
+        archive(ldepth_stencil_attachments);
+        archive(ldependencies);
+        archive(lframebuffers);
+        archive(lshader_modules);
+        archive(ldesc_set_layouts);
+        archive(lpipeline_layouts);
+        archive(lcompute_pipelines);
+        archive(lgraphics_pipelines);
+        break;
+
+      case LayoutSection::kCommands:
+        archive(lcameras);
+        archive(lcmd_groups);
+        archive(lcmd_lists);
+        archive(lcmd_contexts);
+        archive(lfunctions);
+        archive(lbuffer_memory_barriers);
+        archive(limage_memory_barriers);
+        archive(lcopy_buffers);
+        archive(lbegin_render_passes);
+        archive(lbind_desc_sets);
+        archive(lbind_pipelines);
+        archive(lbind_vertex_buffers);
+        archive(lbind_index_buffers);
+        archive(ldraw_indexed_indirects);
+        archive(lblit_images);
+        archive(lpush_constants);
+        archive(lreset_query_pools);
+        archive(lset_events);
+        archive(lreset_events);
+        archive(ldraw_overlays);
+        archive(loverlays);
+        archive(lwindow_viewers);
+        archive(lqueue_submits);
+        archive(lqueue_presents);
+#ifdef XG_ENABLE_REALITY
+        archive(lcomposition_layer_projections);
+        archive(lreality_viewers);
+#endif  // XG_ENABLE_REALITY
+        archive(lnodes);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  // Every layout is written after a header with the version of the format,
+  // compressed, sectioned or as is. All load with Deserialize, which returns
+  // nullptr for a file of another version or a corrupted one.
+  bool Serialize(const std::string& filepath,
+                 const LayoutSerializeInfo& info = {});
+  static std::shared_ptr<Layout> Deserialize(
+      const std::string& filepath,
+      const std::vector<uint8_t>* dictionary = nullptr);
+};
+
+class LayoutInStreamBuffer;
+
+// Reads a sectioned layout file section by section. The nodes are decoded when
+// their section is loaded, the blobs not until they are used, which for the
+// data of a buffer loader is when the loader runs. The nodes of the loaded
+// sections are found by id through the layout.
+class LayoutReader {
+ public:
+  static std::unique_ptr<LayoutReader> Open(const std::string& filepath);
+
+  ~LayoutReader();
+
+  // Loads |section| and any section before it that is not loaded yet.
+  bool Load(LayoutSection section);
+  bool IsLoaded(LayoutSection section) const {
+    return static_cast<uint32_t>(section) < loaded_count_;
+  }
+
+  std::shared_ptr<Layout> GetLayout() const { return layout_; }
+
+ private:
+  LayoutReader() = default;
+  LayoutReader(const LayoutReader&) = delete;
+  LayoutReader& operator=(const LayoutReader&) = delete;
+
+  struct SectionEntry {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  std::shared_ptr<const std::string> filepath_;
+  std::shared_ptr<MappedFile> packed_file_;  // read by |stream_buffer_|
+  std::vector<SectionEntry> sections_;
+  std::unique_ptr<LayoutInStreamBuffer> stream_buffer_;
+  std::unique_ptr<std::istream> stream_;
+  std::unique_ptr<cereal::BinaryInputArchive> archive_;
+  std::unique_ptr<LayoutBlobSection> blob_section_;
+  std::shared_ptr<Layout> layout_;
+  uint32_t loaded_count_ = 0;
+  bool failed_ = false;
 };
 
 }  // namespace xg
@@ -0,0 +1,104 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#ifndef XG_LAYOUT_HASH_H_
+#define XG_LAYOUT_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cereal/cereal.hpp"
+#include "xg/layout.h"
+#include "xg/utility.h"
+
+namespace xg {
+
+// Hashes the fields of a single node, as they are archived. The nodes it
+// refers to are not followed, only collected in order, so that the caller
+// can combine their hashes.
+class LayoutHashArchive
+    : public cereal::OutputArchive<LayoutHashArchive,
+                                   cereal::AllowEmptyClassElision> {
+ public:
+  LayoutHashArchive()
+      : cereal::OutputArchive<LayoutHashArchive,
+                              cereal::AllowEmptyClassElision>(this) {}
+
+  // through the polymorphic bindings, as the dynamic type of |node|
+  void AddNode(const LayoutBase* node) {
+    std::unique_ptr<const LayoutBase, NullDeleter> view(node);
+    (*this)(view);
+  }
+
+  void AddData(const void* data, size_t size) {
+    hash_ = HashData(data, size, hash_);
+  }
+
+  void AddReference(const LayoutBase* node) {
+    const uint8_t valid = node ? 1 : 0;
+    AddData(&valid, sizeof(valid));
+    if (node) references_.emplace_back(node);
+  }
+
+  uint64_t GetHash() const { return hash_; }
+  std::vector<const LayoutBase*> TakeReferences() {
+    return std::move(references_);
+  }
+
+ private:
+  struct NullDeleter {
+    void operator()(const LayoutBase*) const {}
+  };
+
+  uint64_t hash_ = HashData(nullptr, 0);
+  std::vector<const LayoutBase*> references_;
+};
+
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_SAVE_FUNCTION_NAME(LayoutHashArchive& archive, const T& value) {
+  archive.AddData(std::addressof(value), sizeof(value));
+}
+
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(LayoutHashArchive& archive,
+                                      const cereal::BinaryData<T>& data) {
+  archive.AddData(data.data, static_cast<size_t>(data.size));
+}
+
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(LayoutHashArchive& archive,
+                                           cereal::NameValuePair<T>& pair) {
+  archive(pair.value);
+}
+
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(LayoutHashArchive& archive,
+                                           cereal::SizeTag<T>& tag) {
+  archive(tag.size);
+}
+
+// also reached through weak pointers, which archive the locked pointer
+template <class T>
+inline typename std::enable_if<std::is_base_of<LayoutBase, T>::value,
+                               void>::type
+CEREAL_SAVE_FUNCTION_NAME(LayoutHashArchive& archive,
+                          const std::shared_ptr<T>& node) {
+  archive.AddReference(node.get());
+}
+
+}  // namespace xg
+
+// binds the layout types registered in layout.cc to this archive as well
+CEREAL_REGISTER_ARCHIVE(xg::LayoutHashArchive)
+
+#endif  // XG_LAYOUT_HASH_H_
@@ -0,0 +1,459 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "xg/layout_patch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cereal/archives/binary.hpp"
+#include "cereal/types/polymorphic.hpp"
+#include "xg/layout.h"
+#include "xg/layout_hash.h"
+#include "xg/logger.h"
+#include "xg/utility.h"
+
+namespace xg {
+
+static constexpr uint32_t kLayoutPatchVersion = 1;
+
+// A node vector of a layout, or a single node.
+class NodeContainer {
+ public:
+  virtual ~NodeContainer() = default;
+
+  virtual size_t GetSize() const = 0;
+  virtual std::shared_ptr<LayoutBase> Get(size_t index) const = 0;
+  virtual bool Set(size_t index, std::shared_ptr<LayoutBase> node) = 0;
+  virtual bool Add(std::shared_ptr<LayoutBase> node) = 0;
+  virtual void Remove(size_t index) = 0;
+};
+
+template <typename T>
+class VectorContainer : public NodeContainer {
+ public:
+  explicit VectorContainer(std::vector<std::shared_ptr<T>>* nodes)
+      : nodes_(nodes) {}
+
+  size_t GetSize() const override { return nodes_->size(); }
+  std::shared_ptr<LayoutBase> Get(size_t index) const override {
+    return (*nodes_)[index];
+  }
+  bool Set(size_t index, std::shared_ptr<LayoutBase> node) override {
+    auto typed = std::dynamic_pointer_cast<T>(node);
+    if (!typed) return false;
+    (*nodes_)[index] = std::move(typed);
+    return true;
+  }
+  bool Add(std::shared_ptr<LayoutBase> node) override {
+    auto typed = std::dynamic_pointer_cast<T>(node);
+    if (!typed) return false;
+    nodes_->emplace_back(std::move(typed));
+    return true;
+  }
+  void Remove(size_t index) override {
+    nodes_->erase(nodes_->begin() + index);
+  }
+
+ private:
+  std::vector<std::shared_ptr<T>>* nodes_;
+};
+
+template <typename T>
+class PointerContainer : public NodeContainer {
+ public:
+  explicit PointerContainer(std::shared_ptr<T>* node) : node_(node) {}
+
+  size_t GetSize() const override { return *node_ ? 1 : 0; }
+  std::shared_ptr<LayoutBase> Get(size_t index) const override {
+    return *node_;
+  }
+  bool Set(size_t index, std::shared_ptr<LayoutBase> node) override {
+    auto typed = std::dynamic_pointer_cast<T>(node);
+    if (!typed) return false;
+    *node_ = std::move(typed);
+    return true;
+  }
+  bool Add(std::shared_ptr<LayoutBase> node) override {
+    return !*node_ && Set(0, std::move(node));
+  }
+  void Remove(size_t index) override { node_->reset(); }
+
+ private:
+  std::shared_ptr<T>* node_;
+};
+
+// Passed as the archive of Layout::SerializeSection, so that the node
+// containers are visited in the order they are archived.
+template <typename Func>
+class ContainerVisitor {
+ public:
+  explicit ContainerVisitor(Func func) : func_(func) {}
+
+  template <typename T>
+  void operator()(std::vector<std::shared_ptr<T>>& nodes) {
+    VectorContainer<T> container(&nodes);
+    func_(container);
+  }
+
+  template <typename T>
+  void operator()(std::shared_ptr<T>& node) {
+    PointerContainer<T> container(&node);
+    func_(container);
+  }
+
+ private:
+  Func func_;
+};
+
+template <typename Func>
+static void ForEachContainer(Layout* layout, Func func) {
+  ContainerVisitor<Func> visitor(func);
+  for (auto section : {LayoutSection::kDevice, LayoutSection::kResources,
+                       LayoutSection::kPipelines, LayoutSection::kCommands}) {
+    layout->SerializeSection(visitor, section);
+  }
+}
+
+struct NodeEntry {
+  std::shared_ptr<LayoutBase> node;
+  uint32_t container;
+  size_t index;
+};
+
+// Keyed by id, or by the container and the position among the nodes
+// without an id for the rest. Sorted, so both ends agree on the order.
+static std::map<std::string, NodeEntry> CollectNodes(Layout* layout) {
+  std::map<std::string, NodeEntry> nodes;
+  uint32_t container_index = 0;
+
+  ForEachContainer(layout, [&](NodeContainer& container) {
+    size_t unnamed_count = 0;
+    for (size_t i = 0; i < container.GetSize(); ++i) {
+      const auto node = container.Get(i);
+      if (!node) continue;
+
+      auto key = node->id;
+      if (key.empty()) {
+        key = "#" + std::to_string(container_index) + ":" +
+              std::to_string(unnamed_count++);
+      }
+      nodes.emplace(std::move(key), NodeEntry{node, container_index, i});
+    }
+    ++container_index;
+  });
+  return nodes;
+}
+
+// Hashes each node of a layout once. The hash of a node combines the hash of
+// its own fields with the hashes of the nodes it refers to, which are
+// finished first, in reverse topological order. The nodes of a reference
+// cycle are hashed together and share the hash.
+class LayoutHasher {
+ public:
+  uint64_t GetHash(const LayoutBase* node) { return Visit(node).hash; }
+
+ private:
+  struct Entry {
+    uint64_t fields = 0;
+    uint64_t hash = 0;
+    std::vector<const LayoutBase*> references;
+    uint32_t index = 0;
+    uint32_t low_link = 0;
+    uint32_t position = 0;  // in its cycle
+    bool on_stack = false;
+  };
+
+  // Tarjan's algorithm, which finishes the strongly connected components
+  // after those they refer to.
+  Entry& Visit(const LayoutBase* node) {
+    auto& entry = entries_[node];
+    if (entry.index != 0) return entry;
+
+    entry.index = entry.low_link = next_index_++;
+    {
+      LayoutHashArchive archive;
+      archive.AddNode(node);
+      entry.fields = archive.GetHash();
+      entry.references = archive.TakeReferences();
+    }
+    stack_.emplace_back(node);
+    entry.on_stack = true;
+
+    for (const auto* reference : entry.references) {
+      const auto& next = Visit(reference);
+      if (next.on_stack) {
+        entry.low_link = std::min(entry.low_link, next.low_link);
+      }
+    }
+
+    if (entry.low_link == entry.index) Finish(node);
+    return entry;
+  }
+
+  void Finish(const LayoutBase* root) {
+    const auto it = std::find(stack_.begin(), stack_.end(), root);
+    std::vector<Entry*> members;
+    for (auto member = it; member != stack_.end(); ++member) {
+      members.emplace_back(&entries_[*member]);
+    }
+    stack_.erase(it, stack_.end());
+
+    // in the same order however the cycle was entered
+    std::stable_sort(members.begin(), members.end(),
+                     [](const Entry* a, const Entry* b) {
+                       return a->fields < b->fields;
+                     });
+    for (size_t i = 0; i < members.size(); ++i) {
+      members[i]->position = static_cast<uint32_t>(i);
+    }
+
+    auto hash = HashData(nullptr, 0);
+    for (const auto* member : members) {
+      hash = HashData(&member->fields, sizeof(member->fields), hash);
+      for (const auto* reference : member->references) {
+        const auto& next = entries_[reference];
+        const uint64_t value = next.on_stack ? next.position : next.hash;
+        hash = HashData(&value, sizeof(value), hash);
+      }
+    }
+
+    for (auto* member : members) {
+      member->on_stack = false;
+      member->hash = hash;
+    }
+  }
+
+  std::unordered_map<const LayoutBase*, Entry> entries_;
+  std::vector<const LayoutBase*> stack_;
+  uint32_t next_index_ = 1;
+};
+
+// Reads from or appends to |bytes|, which are loaded and saved in one piece.
+class BytesStreamBuffer : public std::streambuf {
+ public:
+  explicit BytesStreamBuffer(std::vector<uint8_t>* bytes) : bytes_(bytes) {
+    auto* data = reinterpret_cast<char*>(bytes_->data());
+    setg(data, data, data + bytes_->size());
+  }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      bytes_->emplace_back(static_cast<uint8_t>(traits_type::to_char_type(c)));
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    bytes_->insert(bytes_->end(), s, s + n);
+    return n;
+  }
+
+ private:
+  std::vector<uint8_t>* bytes_;
+};
+
+std::shared_ptr<LayoutPatch> LayoutPatch::Create(const Layout& base,
+                                                 const Layout& edited) {
+  // only read, SerializeSection is not const for loading
+  const auto base_nodes = CollectNodes(const_cast<Layout*>(&base));
+  const auto edited_nodes = CollectNodes(const_cast<Layout*>(&edited));
+  LayoutHasher base_hasher;
+  LayoutHasher edited_hasher;
+
+  auto patch = std::make_shared<LayoutPatch>();
+  if (!patch) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  for (const auto& base_node : base_nodes) {
+    if (edited_nodes.find(base_node.first) == edited_nodes.end()) {
+      patch->removed.emplace_back(base_node.first);
+    }
+  }
+
+  for (const auto& edited_node : edited_nodes) {
+    const auto& entry = edited_node.second;
+    const auto it = base_nodes.find(edited_node.first);
+
+    if (it != base_nodes.end() &&
+        it->second.node->layout_type == entry.node->layout_type &&
+        base_hasher.GetHash(it->second.node.get()) ==
+            edited_hasher.GetHash(entry.node.get())) {
+      patch->anchors.emplace_back(entry.node);
+    } else {
+      patch->changed.emplace_back(
+          Node{edited_node.first, entry.container, entry.node});
+    }
+  }
+
+  XG_DEBUG("layout patch: {} changed, {} removed, {} unchanged",
+           patch->changed.size(), patch->removed.size(),
+           patch->anchors.size());
+
+  return patch;
+}
+
+bool LayoutPatch::Serialize(const std::string& filepath) const {
+  std::vector<uint8_t> bytes;
+  BytesStreamBuffer stream_buffer(&bytes);
+  std::ostream stream(&stream_buffer);
+  {
+    cereal::BinaryOutputArchive archive(stream);
+    archive(kLayoutPatchVersion, removed);
+    archive(cereal::make_size_tag(
+        static_cast<cereal::size_type>(changed.size())));
+    for (const auto& change : changed) archive(change.key, change.container);
+    archive(static_cast<uint64_t>(anchors.size()));
+
+    // written as ids from here on, before any other pointer is archived
+    for (const auto& anchor : anchors) archive.registerSharedPointer(anchor);
+    for (const auto& change : changed) archive(change.node);
+  }
+
+  return SaveFile(filepath, bytes);
+}
+
+std::shared_ptr<LayoutPatch> LayoutPatch::Deserialize(
+    const std::string& filepath, const Layout& layout) {
+  std::vector<uint8_t> bytes;
+  if (!LoadFile(filepath, &bytes)) return nullptr;
+
+  auto patch = std::make_shared<LayoutPatch>();
+  if (!patch) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  BytesStreamBuffer stream_buffer(&bytes);
+  std::istream stream(&stream_buffer);
+
+  // a truncated or corrupted patch makes cereal throw
+  try {
+    cereal::BinaryInputArchive archive(stream);
+    uint32_t version = 0;
+    archive(version);
+    if (version != kLayoutPatchVersion) {
+      XG_ERROR("unsupported layout patch: {}", filepath);
+      return nullptr;
+    }
+
+    archive(patch->removed);
+    cereal::size_type changed_count = 0;
+    archive(cereal::make_size_tag(changed_count));
+    patch->changed.resize(static_cast<size_t>(changed_count));
+    for (auto& change : patch->changed) archive(change.key, change.container);
+
+    // the unchanged nodes, in the order they were registered when written
+    auto nodes = CollectNodes(const_cast<Layout*>(&layout));
+    for (const auto& key : patch->removed) nodes.erase(key);
+    for (const auto& change : patch->changed) nodes.erase(change.key);
+
+    uint64_t anchor_count = 0;
+    archive(anchor_count);
+    if (anchor_count != nodes.size()) {
+      XG_ERROR("layout patch does not match the layout: {}", filepath);
+      return nullptr;
+    }
+
+    uint32_t id = 1;
+    for (const auto& node : nodes) {
+      archive.registerSharedPointer(id++, node.second.node);
+      patch->anchors.emplace_back(node.second.node);
+    }
+    for (auto& change : patch->changed) archive(change.node);
+  } catch (const std::exception& e) {
+    XG_ERROR("corrupted layout patch: {}, error: {}", filepath, e.what());
+    return nullptr;
+  }
+
+  return patch;
+}
+
+bool LayoutPatch::Apply(
+    Layout* layout,
+    std::vector<std::shared_ptr<LayoutBase>>* changed_nodes) const {
+  assert(layout);
+
+  auto nodes = CollectNodes(layout);
+
+  // the engine writes what it derives into the nodes it creates, and keeps
+  // instances of them, neither of which a patch can update
+  for (const auto& node : nodes) {
+    if (node.second.node->instance) {
+      XG_ERROR("layout patch applied to a loaded layout: {}", node.first);
+      return false;
+    }
+  }
+
+  std::vector<std::pair<uint32_t, size_t>> removals;
+  size_t applied_count = 0;
+  bool result = true;
+
+  for (const auto& key : removed) {
+    const auto it = nodes.find(key);
+    if (it == nodes.end()) continue;
+
+    removals.emplace_back(it->second.container, it->second.index);
+    if (!it->second.node->id.empty()) {
+      layout->node_id_map.erase(it->second.node->id);
+    }
+  }
+  // removed back to front, so the indices stay valid
+  std::sort(removals.rbegin(), removals.rend());
+
+  uint32_t container_index = 0;
+  ForEachContainer(layout, [&](NodeContainer& container) {
+    for (const auto& change : changed) {
+      const auto it = nodes.find(change.key);
+      const bool replace =
+          it != nodes.end() && it->second.container == container_index;
+      const bool add = it == nodes.end() && change.container == container_index;
+      if (!replace && !add) continue;
+
+      if (!(replace ? container.Set(it->second.index, change.node)
+                    : container.Add(change.node))) {
+        XG_ERROR("layout patch node of wrong type: {}", change.key);
+        result = false;
+        continue;
+      }
+
+      ++applied_count;
+      if (!change.node->id.empty()) {
+        layout->node_id_map[change.node->id] = change.node;
+      }
+      if (changed_nodes) changed_nodes->emplace_back(change.node);
+    }
+
+    for (const auto& removal : removals) {
+      if (removal.first == container_index) container.Remove(removal.second);
+    }
+    ++container_index;
+  });
+
+  if (applied_count != changed.size()) {
+    XG_ERROR("layout patch does not match the layout");
+    result = false;
+  }
+  return result;
+}
+
+}  // namespace xg
@@ -0,0 +1,60 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#ifndef XG_LAYOUT_PATCH_H_
+#define XG_LAYOUT_PATCH_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xg/layout.h"
+
+namespace xg {
+
+// The changes from one layout to another. Nodes are matched by id, or by
+// their position among the nodes without one, and compared by a hash of
+// their fields combined with the hashes of the nodes they refer to. So a
+// node that refers to a changed node is changed as well.
+struct LayoutPatch {
+  struct Node {
+    std::string key;
+    uint32_t container = 0;  // the layout vector, for added nodes
+    std::shared_ptr<LayoutBase> node;
+  };
+
+  std::vector<std::string> removed;
+  std::vector<Node> changed;
+
+  // Both layouts should be as parsed, before the engine has used them.
+  static std::shared_ptr<LayoutPatch> Create(const Layout& base,
+                                             const Layout& edited);
+
+  // The unchanged nodes the changed ones refer to are written as references,
+  // which are resolved against |layout| on load. It is the layout the patch
+  // is applied to, with the same nodes as the base of the patch.
+  bool Serialize(const std::string& filepath) const;
+  static std::shared_ptr<LayoutPatch> Deserialize(const std::string& filepath,
+                                                  const Layout& layout);
+
+  // Replaces the changed nodes of |layout|, and adds and removes nodes. The
+  // layout must be as parsed or deserialized, and fails to apply once the
+  // engine has loaded it. A patch saves parsing the edited layout: to see
+  // the edit, the patched layout is loaded with Engine::Load, which keeps
+  // the windows, device and queues and creates the rest again.
+  bool Apply(Layout* layout,
+             std::vector<std::shared_ptr<LayoutBase>>* changed_nodes) const;
+
+  // the unchanged nodes of the edited layout, in key order
+  std::vector<std::shared_ptr<LayoutBase>> anchors;
+};
+
+}  // namespace xg
+
+#endif  // XG_LAYOUT_PATCH_H_
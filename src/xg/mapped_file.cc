@@ -0,0 +1,239 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "xg/mapped_file.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <string>
+
+// Android counts as Linux here. Its files on the file system are mapped, and
+// the assets inside the apk, which have no file descriptor, are read.
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#define XG_MAPPED_FILE_MMAP
+#elif defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define XG_MAPPED_FILE_WIN32
+#endif
+
+#include "SDL.h"
+#include "xg/asset_pack.h"
+#include "xg/logger.h"
+#include "xg/types.h"
+#include "xg/utility.h"
+
+namespace xg {
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& filepath) {
+  assert(!filepath.empty());
+
+  auto mapped_file = AssetPackRegistry::Get().Find(filepath);
+  if (mapped_file) return mapped_file;
+
+  mapped_file = Map(filepath);
+  if (mapped_file) return mapped_file;
+
+  XG_DEBUG("read file: {}", filepath);
+
+  mapped_file = std::make_shared<MappedFile>();
+  if (!mapped_file) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  auto* rw = SDL_RWFromFile(filepath.c_str(), "rb");
+  if (!rw) {
+    XG_ERROR("failed to open file: {}, error: {}", filepath, SDL_GetError());
+    return nullptr;
+  }
+
+  const auto size = SDL_RWsize(rw);
+  assert(size >= 0);
+
+  // not value-initialized, the whole buffer is overwritten by the read
+  mapped_file->buffer_.reset(new (std::nothrow) uint8_t[size]);
+  if (!mapped_file->buffer_) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    SDL_RWclose(rw);
+    return nullptr;
+  }
+
+  const auto size_read = SDL_RWread(rw, mapped_file->buffer_.get(), 1, size);
+  SDL_RWclose(rw);
+  if (size_read != size) {
+    XG_ERROR("read file size incorrect: {} != {}", size_read, size);
+    return nullptr;
+  }
+
+  mapped_file->data_ = mapped_file->buffer_.get();
+  mapped_file->size_ = static_cast<size_t>(size);
+
+  return mapped_file;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Map(const std::string& filepath) {
+  assert(!filepath.empty());
+
+#if defined(XG_MAPPED_FILE_MMAP)
+  const int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return nullptr;
+
+  XG_DEBUG("map file: {}", filepath);
+
+  auto mapped_file = std::make_shared<MappedFile>();
+  if (!mapped_file) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    close(fd);
+    return nullptr;
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st) == -1) {
+    XG_ERROR("failed to stat file: {}, error: {}", filepath, strerror(errno));
+    close(fd);
+    return nullptr;
+  }
+
+  mapped_file->size_ = static_cast<size_t>(st.st_size);
+  if (mapped_file->size_ > 0) {
+    void* addr =
+        mmap(nullptr, mapped_file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      XG_ERROR("failed to map file: {}, error: {}", filepath, strerror(errno));
+      close(fd);
+      return nullptr;
+    }
+    mapped_file->data_ = static_cast<const uint8_t*>(addr);
+    mapped_file->mapped_ = true;
+  }
+  close(fd);
+
+  return mapped_file;
+#elif defined(XG_MAPPED_FILE_WIN32)
+  const auto file =
+      CreateFileA(filepath.c_str(), GENERIC_READ,
+                  FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                  FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+  XG_DEBUG("map file: {}", filepath);
+
+  auto mapped_file = std::make_shared<MappedFile>();
+  if (!mapped_file) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  LARGE_INTEGER size = {};
+  if (!GetFileSizeEx(file, &size)) {
+    XG_ERROR("failed to stat file: {}, error: {}", filepath, GetLastError());
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  // an empty file cannot be mapped, and needs not be
+  mapped_file->size_ = static_cast<size_t>(size.QuadPart);
+  if (mapped_file->size_ > 0) {
+    const auto mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* addr =
+        mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!addr) {
+      XG_ERROR("failed to map file: {}, error: {}", filepath, GetLastError());
+      if (mapping) CloseHandle(mapping);
+      CloseHandle(file);
+      return nullptr;
+    }
+    // the view keeps the mapping and the file open
+    CloseHandle(mapping);
+    mapped_file->data_ = static_cast<const uint8_t*>(addr);
+    mapped_file->mapped_ = true;
+  }
+  CloseHandle(file);
+
+  return mapped_file;
+#else
+  return nullptr;
+#endif
+}
+
+std::shared_ptr<MappedFile> MappedFile::Slice(std::shared_ptr<MappedFile> file,
+                                              size_t offset, size_t size) {
+  assert(file);
+  assert(offset <= file->size_ && size <= file->size_ - offset);
+
+  auto mapped_file = std::make_shared<MappedFile>();
+  if (!mapped_file) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  mapped_file->data_ = file->data_ + offset;
+  mapped_file->size_ = size;
+  mapped_file->parent_ = std::move(file);
+  return mapped_file;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Wrap(std::unique_ptr<uint8_t[]> buffer,
+                                             size_t size) {
+  auto mapped_file = std::make_shared<MappedFile>();
+  if (!mapped_file) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  mapped_file->buffer_ = std::move(buffer);
+  mapped_file->data_ = mapped_file->buffer_.get();
+  mapped_file->size_ = size;
+  return mapped_file;
+}
+
+void MappedFile::Discard(size_t offset, size_t size) {
+  if (parent_) {
+    if (offset < size_) {
+      parent_->Discard(static_cast<size_t>(data_ - parent_->data_) + offset,
+                       std::min(size, size_ - offset));
+    }
+    return;
+  }
+
+#ifdef XG_MAPPED_FILE_MMAP
+  if (!mapped_ || offset >= size_) return;
+
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const auto begin = offset - offset % page_size;
+  const auto end = std::min(offset + size, size_);
+  madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_DONTNEED);
+#endif  // XG_MAPPED_FILE_MMAP
+}
+
+MappedFile::~MappedFile() {
+#if defined(XG_MAPPED_FILE_MMAP)
+  if (mapped_) munmap(const_cast<uint8_t*>(data_), size_);
+#elif defined(XG_MAPPED_FILE_WIN32)
+  if (mapped_) UnmapViewOfFile(data_);
+#endif
+}
+
+}  // namespace xg
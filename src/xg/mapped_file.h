@@ -0,0 +1,59 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#ifndef XG_MAPPED_FILE_H_
+#define XG_MAPPED_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace xg {
+
+// A read-only view of a whole file. It is mapped into memory where the
+// platform allows it, otherwise it is read through SDL.
+class MappedFile {
+ public:
+  // Entries of mounted asset packs are found before the files.
+  static std::shared_ptr<MappedFile> Open(const std::string& filepath);
+  // Only maps, and returns nullptr where the file cannot be mapped, such as
+  // the assets inside an Android apk. It does not search the asset packs.
+  static std::shared_ptr<MappedFile> Map(const std::string& filepath);
+  // A view of a range of |file|, which it keeps alive.
+  static std::shared_ptr<MappedFile> Slice(std::shared_ptr<MappedFile> file,
+                                           size_t offset, size_t size);
+  static std::shared_ptr<MappedFile> Wrap(std::unique_ptr<uint8_t[]> buffer,
+                                          size_t size);
+
+  MappedFile() = default;
+  ~MappedFile();
+
+  const uint8_t* GetData() const { return data_; }
+  size_t GetSize() const { return size_; }
+  bool IsMapped() const { return mapped_; }
+
+  // Drops the pages of a range that has been consumed. They are read back
+  // from the file if accessed again.
+  void Discard(size_t offset, size_t size);
+
+ private:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::unique_ptr<uint8_t[]> buffer_;
+  std::shared_ptr<MappedFile> parent_;
+};
+
+}  // namespace xg
+
+#endif  // XG_MAPPED_FILE_H_
@@ -27,7 +27,8 @@ class Overlay {
   Overlay& operator=(Overlay&&) = delete;
   virtual ~Overlay() = default;
 
-  virtual bool AddFont(const std::vector<uint8_t>& data, float pixel_size) = 0;
+  virtual bool AddFont(const uint8_t* data, size_t size,
+                       float pixel_size) = 0;
   virtual bool CreateFontsTexture(const CommandBuffer* cmd) = 0;
   virtual void DestroyFontUploadObjects() = 0;
   virtual void Draw(const CommandBuffer* cmd) = 0;
@@ -19,20 +19,22 @@ namespace xg {
 
 bool OverlayImGui::Initialize() { return IMGUI_CHECKVERSION(); }
 
-bool OverlayImGui::AddFont(const std::vector<uint8_t>& data, float pixel_size) {
-  auto buffer = static_cast<uint8_t*>(IM_ALLOC(data.size()));
+bool OverlayImGui::AddFont(const uint8_t* data, size_t size,
+                           float pixel_size) {
+  // the atlas owns and frees the font data
+  auto buffer = static_cast<uint8_t*>(IM_ALLOC(size));
   if (!buffer) {
     XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
     return false;
   }
 
-  std::copy(data.begin(), data.end(), buffer);
+  std::copy(data, data + size, buffer);
 
   assert(ctxt_);
   const auto& io = ImGui::GetIO();
 
   auto font = io.Fonts->AddFontFromMemoryTTF(
-      buffer, static_cast<int>(data.size()), pixel_size);
+      buffer, static_cast<int>(size), pixel_size);
   if (!font) {
     XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
     return false;
@@ -23,7 +23,7 @@ class OverlayImGui : public Overlay {
 
   OverlayImGui() = default;
 
-  bool AddFont(const std::vector<uint8_t>& data, float pixel_size) override;
+  bool AddFont(const uint8_t* data, size_t size, float pixel_size) override;
 
  protected:
   std::shared_ptr<Window> win_;
@@ -9,13 +9,24 @@
 #ifndef XG_PARSER_H_
 #define XG_PARSER_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "xg/layout.h"
 
+namespace tinyxml2 {
+class XMLElement;
+}  // namespace tinyxml2
+
 namespace xg {
 
+enum class ParseMode {
+  kDocument,
+  kStream,
+};
+
 class Parser {
  public:
   static Parser& Get() {
@@ -23,7 +34,33 @@ class Parser {
     return parser;
   }
 
-  std::shared_ptr<Layout> ParseFile(const std::string& xml_path);
+  // |dependencies| receives the files the layout is parsed from, unless it
+  // is loaded from the cache.
+  std::shared_ptr<Layout> ParseFile(
+      const std::string& xml_path, ParseMode mode = ParseMode::kDocument,
+      std::vector<std::string>* dependencies = nullptr);
+
+  // Parses the layouts concurrently on the thread pool. The result for a
+  // layout that fails to parse is nullptr.
+  std::vector<std::shared_ptr<Layout>> ParseFiles(
+      const std::vector<std::string>& xml_paths,
+      ParseMode mode = ParseMode::kDocument);
+
+  // Parsed layouts are serialized into |cache_dir| and loaded from there
+  // while neither the xml nor the files it depends on change. The directory
+  // must exist. An empty one disables the cache.
+  void SetCacheDirectory(const std::string& cache_dir) {
+    cache_dir_ = cache_dir;
+  }
+
+  using ParsedHandlerType = void(const Layout& layout);
+
+  // Called when the elements are parsed, before their references are
+  // resolved. It may be called from several threads at a time by
+  // ParseFiles().
+  void SetParsedHandler(std::function<ParsedHandlerType> handler) {
+    parsed_handler_ = handler;
+  }
 
  private:
   Parser() = default;
@@ -32,8 +69,16 @@ class Parser {
   Parser(Parser&&) = delete;
   Parser& operator=(Parser&&) = delete;
 
+  std::shared_ptr<Layout> ParseDocument(const std::string& xml_path);
+  std::shared_ptr<Layout> ParseStream(const std::string& xml_path);
+  bool ParseChildren(std::shared_ptr<Layout> layout,
+                     std::shared_ptr<LayoutBase> parent,
+                     const tinyxml2::XMLElement* first_child);
   void AddLayoutNode(std::shared_ptr<Layout> layout, std::shared_ptr<LayoutBase> node);
-  void ResolveLayoutReferences(std::shared_ptr<Layout> layout);
+  bool ResolveLayoutReferences(std::shared_ptr<Layout> layout);
+
+  std::string cache_dir_;
+  std::function<ParsedHandlerType> parsed_handler_;
 };
 
 }  // namespace xg
@@ -8,36 +8,147 @@
 
 #include "xg/parser/parser_internal.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "exprtk/exprtk.hpp"
+#include "xg/thread_pool.h"
 
 namespace xg {
 namespace parser {
 
-static exprtk::symbol_table<float> symbol_table;
-static exprtk::parser<float> parser;
+struct CompiledExpression {
+  uint64_t generation = 0;
+  exprtk::expression<float> expression;
+};
 
-Expression::Expression() {
-  symbol_table.add_constants();
-}
+struct Expression::Impl {
+  exprtk::symbol_table<float> symbol_table;
+  exprtk::parser<float> parser;
+  exprtk::parser<double> generate_parser;
+  std::unordered_map<std::string, CompiledExpression> expression_cache;
+};
 
-Expression::~Expression() {
-  symbol_table.clear();
+Expression::Expression() : impl_(std::make_unique<Impl>()) {
+  impl_->symbol_table.add_constants();
 }
 
-void Expression::Reset() {
-  symbol_table.clear_variables();
-  symbol_table.add_constants();
-}
+Expression::~Expression() = default;
 
 void Expression::AddConstant(const char* name, float value) {
-  symbol_table.add_constant(name, value);
+  std::lock_guard<std::mutex> lock(mutex_);
+  impl_->symbol_table.add_constant(name, value);
+  ++generation_;
 }
 
 float Expression::Evaluate(const char* expr) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& expression_cache = impl_->expression_cache;
+  auto& compiled = expression_cache[expr];
+  if (compiled.generation == generation_) {
+    ++cache_hits_;
+    return compiled.expression.value();
+  }
+  ++cache_misses_;
+
   exprtk::expression<float> expression;
-  expression.register_symbol_table(symbol_table);
-  parser.compile(expr, expression);
-  return expression.value();
+  expression.register_symbol_table(impl_->symbol_table);
+  if (!impl_->parser.compile(expr, expression)) {
+    expression_cache.erase(expr);
+    return expression.value();
+  }
+  compiled.generation = generation_;
+  compiled.expression = expression;
+  return compiled.expression.value();
+}
+
+// below this many values per task, posting costs more than evaluating
+static constexpr size_t kMinGenerateCount = 4096;
+
+// Evaluates a range of indices. Each task compiles the expression against
+// symbol tables of its own, because exprtk reference counts shared symbol
+// tables without synchronization.
+class GenerateTask : public Task {
+ public:
+  using Constants = std::vector<std::pair<std::string, float>>;
+
+  GenerateTask(size_t begin, size_t end, size_t stride,
+               Expression::StoreFunc store, uint8_t* dst)
+      : begin_(begin), end_(end), stride_(stride), store_(store), dst_(dst) {}
+
+  bool Compile(const char* expr, const Constants& constants,
+               exprtk::parser<double>* parser) {
+    for (const auto& constant : constants) {
+      symbol_table_.add_constant(constant.first, constant.second);
+    }
+    symbol_table_.add_variable("i", index_);
+    expression_.register_symbol_table(symbol_table_);
+    return parser->compile(expr, expression_);
+  }
+
+  void Run(std::shared_ptr<Task> self) override {
+    auto dst = dst_ + begin_ * stride_;
+    for (auto i = begin_; i < end_; ++i, dst += stride_) {
+      index_ = static_cast<double>(i);
+      store_(expression_.value(), dst);
+    }
+    barrier_.set_value(nullptr);
+  }
+
+ private:
+  size_t begin_;
+  size_t end_;
+  size_t stride_;
+  Expression::StoreFunc store_;
+  uint8_t* dst_;
+  double index_ = 0.0;
+  exprtk::symbol_table<double> symbol_table_;
+  exprtk::expression<double> expression_;
+};
+
+bool Expression::Generate(const char* expr, size_t count, size_t stride,
+                          StoreFunc store, uint8_t* dst) {
+  if (count == 0) return true;
+
+  // a parse running on a worker does not wait on other workers
+  auto& thread_pool = ThreadPool::Get();
+  const auto task_count =
+      thread_pool.IsWorkerThread()
+          ? 1
+          : std::max<size_t>(1, std::min(thread_pool.GetWorkerCount(),
+                                         count / kMinGenerateCount));
+  const auto per_task = (count + task_count - 1) / task_count;
+  std::vector<std::shared_ptr<GenerateTask>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GenerateTask::Constants constants;
+    impl_->symbol_table.get_variable_list(constants);
+
+    for (size_t i = 0; i < count; i += per_task) {
+      const auto& task = std::make_shared<GenerateTask>(
+          i, std::min(i + per_task, count), stride, store, dst);
+      if (!task->Compile(expr, constants, &impl_->generate_parser)) {
+        return false;
+      }
+      tasks.emplace_back(task);
+    }
+  }
+
+  if (tasks.size() == 1) {
+    tasks.front()->Run(tasks.front());
+    return true;
+  }
+
+  for (const auto& task : tasks) thread_pool.Post(ThreadPool::Job(task));
+  for (const auto& task : tasks) task->Finish();
+
+  return true;
 }
 
 }  // namespace parser
@@ -0,0 +1,192 @@
+// xg - XML Graphics Device
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "xg/parser/parser_internal.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "xg/layout.h"
+#include "xg/logger.h"
+#include "xg/mapped_file.h"
+#include "xg/utility.h"
+
+namespace xg {
+namespace parser {
+
+// bumped whenever the serialized layout changes
+static constexpr uint64_t kLayoutCacheVersion = 4;
+static const char kManifestSignature[] = "xg-layout-cache";
+
+void Dependencies::Add(const char* filepath) {
+  assert(filepath);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::find(files_.begin(), files_.end(), filepath) == files_.end()) {
+    files_.emplace_back(filepath);
+  }
+}
+
+std::vector<std::string> Dependencies::GetFiles() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return files_;
+}
+
+static bool HashFile(const std::string& filepath, uint64_t* hash) {
+  const auto file = MappedFile::Open(filepath);
+  if (!file) return false;
+
+  *hash = HashData(file->GetData(), file->GetSize());
+  return true;
+}
+
+std::string GetLayoutCachePath(const std::string& cache_dir,
+                               const std::string& xml_path) {
+  uint64_t hash = 0;
+  if (!HashFile(xml_path, &hash)) return std::string();
+  hash = HashData(&kLayoutCacheVersion, sizeof(kLayoutCacheVersion), hash);
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016" PRIx64 ".bin", hash);
+
+  if (cache_dir.empty() || cache_dir.back() == '/') return cache_dir + name;
+  return cache_dir + "/" + name;
+}
+
+// The manifest is written after the cached layout, so a layout without one
+// is never used. It lists the hash of every dependency.
+std::shared_ptr<Layout> LoadCachedLayout(const std::string& cache_path) {
+  std::vector<uint8_t> bytes;
+  if (!LoadFile(cache_path + ".dep", &bytes)) return nullptr;
+
+  std::istringstream manifest(std::string(bytes.begin(), bytes.end()));
+  std::string line;
+  if (!std::getline(manifest, line) || line != kManifestSignature) {
+    XG_WARN("invalid layout cache manifest: {}.dep", cache_path);
+    return nullptr;
+  }
+
+  while (std::getline(manifest, line)) {
+    if (line.size() < 18 || line[16] != ' ') {
+      XG_WARN("invalid layout cache manifest: {}.dep", cache_path);
+      return nullptr;
+    }
+
+    char* end = nullptr;
+    const uint64_t expected = std::strtoull(line.c_str(), &end, 16);
+    if (end != line.c_str() + 16) {
+      XG_WARN("invalid layout cache manifest: {}.dep", cache_path);
+      return nullptr;
+    }
+
+    const auto filepath = line.substr(17);
+    uint64_t hash = 0;
+    if (!HashFile(filepath, &hash) || hash != expected) {
+      XG_DEBUG("layout cache outdated by: {}", filepath);
+      return nullptr;
+    }
+  }
+
+  XG_DEBUG("load cached layout: {}", cache_path);
+
+  // a layout cut short by a crash or a full disk, or written by another
+  // version, is dropped and reparsed
+  auto layout = Layout::Deserialize(cache_path);
+  if (!layout) {
+    std::remove((cache_path + ".dep").c_str());
+    std::remove(cache_path.c_str());
+  }
+  return layout;
+}
+
+// Files are written under unique temporary names and renamed into place, so
+// a process or task that has the previous layout mapped keeps reading it, and
+// concurrent writers never interleave.
+static std::string MakeTempPath(const std::string& filepath) {
+  std::random_device random;
+  const auto unique = (static_cast<uint64_t>(random()) << 32) | random();
+
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), ".%016" PRIx64 ".tmp", unique);
+  return filepath + suffix;
+}
+
+static bool ReplaceFile(const std::string& temp_path,
+                        const std::string& filepath) {
+#ifdef _WIN32
+  // rename does not replace an existing file there
+  std::remove(filepath.c_str());
+#endif
+  if (std::rename(temp_path.c_str(), filepath.c_str()) != 0) {
+    XG_ERROR("failed to rename file: {} to {}", temp_path, filepath);
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool SaveCachedLayout(const std::string& cache_path,
+                      std::shared_ptr<Layout> layout,
+                      const std::vector<std::string>& dependencies) {
+  assert(layout);
+
+  std::string manifest = kManifestSignature;
+  manifest += '\n';
+
+  for (const auto& filepath : dependencies) {
+    uint64_t hash = 0;
+    if (!HashFile(filepath, &hash)) return false;
+
+    char hex[32];
+    std::snprintf(hex, sizeof(hex), "%016" PRIx64 " ", hash);
+    manifest += hex + filepath + '\n';
+  }
+
+  // sectioned, so the cached data and shaders are used straight from the
+  // mapping
+  LayoutSerializeInfo info;
+  info.sectioned = true;
+  const auto layout_path = MakeTempPath(cache_path);
+  if (!layout->Serialize(layout_path, info)) {
+    std::remove(layout_path.c_str());
+    return false;
+  }
+
+  const auto manifest_path = MakeTempPath(cache_path + ".dep");
+  if (!SaveFile(manifest_path,
+                std::vector<uint8_t>(manifest.begin(), manifest.end()))) {
+    std::remove(manifest_path.c_str());
+    std::remove(layout_path.c_str());
+    return false;
+  }
+
+  // the old manifest goes first and the new one last, so no manifest is
+  // ever paired with a layout it was not written for
+  std::remove((cache_path + ".dep").c_str());
+  if (!ReplaceFile(layout_path, cache_path)) {
+    std::remove(manifest_path.c_str());
+    return false;
+  }
+  if (!ReplaceFile(manifest_path, cache_path + ".dep")) return false;
+
+  XG_DEBUG("save cached layout: {}", cache_path);
+
+  return true;
+}
+
+}  // namespace parser
+}  // namespace xg
@@ -0,0 +1,138 @@
+// xg - XML Graphics Device
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "xg/parser/parser_internal.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#include "xg/layout.h"
+#include "xg/logger.h"
+#include "xg/utility.h"
+
+namespace xg {
+namespace parser {
+
+static thread_local ParseContext* current_context = nullptr;
+
+ParseContext* ParseContext::GetCurrent() { return current_context; }
+
+ParseContext::Scope::Scope(ParseContext* context)
+    : previous_(current_context) {
+  assert(context);
+  current_context = context;
+}
+
+ParseContext::Scope::~Scope() { current_context = previous_; }
+
+void ParseContext::KeepFragment(std::shared_ptr<void> fragment) {
+  assert(fragment);
+  std::lock_guard<std::mutex> lock(mutex_);
+  fragments_.emplace_back(std::move(fragment));
+}
+
+void ParseContext::AddNode(std::shared_ptr<LayoutBase> node) {
+  assert(node);
+  assert(!node->id.empty());
+
+  std::lock_guard<std::mutex> lock(ids_mutex_);
+  const auto handle = InternHandle(node->id);
+  if (nodes_.size() <= handle) nodes_.resize(handle + 1);
+  nodes_[handle] = std::move(node);
+}
+
+bool ParseContext::ResolveReferences() {
+  std::lock_guard<std::mutex> lock(ids_mutex_);
+  bool result = true;
+
+  for (const auto& reference : references_) {
+    if (reference.handle >= nodes_.size() || !nodes_[reference.handle]) {
+      XG_ERROR("unresolved reference: {}", ids_[reference.handle]);
+      result = false;
+      continue;
+    }
+    reference.assign(reference.slot.get(), reference.index,
+                     nodes_[reference.handle]);
+  }
+  references_.clear();
+  references_.shrink_to_fit();
+
+  return result;
+}
+
+const char* ParseContext::InternId(const char* id) {
+  if (!id) return nullptr;
+
+  std::lock_guard<std::mutex> lock(ids_mutex_);
+  return ids_[InternHandle(id)].c_str();
+}
+
+const char* ParseContext::RecordReference(const char* id,
+                                          std::shared_ptr<void> slot,
+                                          size_t index, AssignFunc assign) {
+  assert(id);
+  assert(slot);
+
+  std::lock_guard<std::mutex> lock(ids_mutex_);
+  const auto handle = InternHandle(id);
+  references_.emplace_back(Reference{handle, index, std::move(slot), assign});
+
+  return ids_[handle].c_str();
+}
+
+uint32_t ParseContext::InternHandle(std::string_view id) {
+  const auto it = handles_.find(id);
+  if (it != handles_.end()) return it->second;
+
+  const auto handle = static_cast<uint32_t>(ids_.size());
+  ids_.emplace_back(id);
+  handles_.emplace(ids_.back(), handle);
+
+  return handle;
+}
+
+std::shared_ptr<LayoutBlob> ParseContext::InternBlob(
+    std::shared_ptr<LayoutBlob> blob) {
+  assert(blob);
+  const auto size = blob->GetSize();
+  if (size == 0) return blob;
+
+  const auto hash = HashData(blob->GetData(), size);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto range = blobs_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const auto& interned = it->second;
+    if (interned->GetSize() == size &&
+        std::memcmp(interned->GetData(), blob->GetData(), size) == 0) {
+      saved_blob_bytes_ += size;
+      return interned;
+    }
+  }
+  blobs_.emplace(hash, blob);
+
+  return blob;
+}
+
+Expression& Expression::Get() {
+  assert(current_context);
+  return current_context->GetExpression();
+}
+
+Dependencies& Dependencies::Get() {
+  assert(current_context);
+  return current_context->GetDependencies();
+}
+
+}  // namespace parser
+}  // namespace xg
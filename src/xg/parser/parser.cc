@@ -10,16 +10,25 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <stack>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "tinyxml2.h"
 #include "xg/layout.h"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/parser/parser_internal.h"
+#include "xg/parser/xml_stream.h"
+#include "xg/thread_pool.h"
 #include "xg/types.h"
 #include "xg/utility.h"
 
@@ -27,249 +36,227 @@ namespace xg {
 
 using namespace parser;
 
+template <typename T>
+static bool ParseElementWith(const tinyxml2::XMLElement* element,
+                             ParserStatus* status) {
+  return T::Get().ParseElement(element, status);
+}
+
 static bool ParseElement(const tinyxml2::XMLElement* element,
                          ParserStatus* status) {
   assert(element);
   assert(status);
 
-  const char* name = element->Name();
-
-  if (strcmp(name, "Engine") == 0) {
-    return ParserEngine::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Constant") == 0) {
-    return ParserConstant::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Data") == 0) {
-    return ParserData::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ResourceLoader") == 0) {
-    return ParserResourceLoader::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Renderer") == 0) {
-    return ParserRenderer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Window") == 0) {
-    return ParserWindow::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Device") == 0) {
-    return ParserDevice::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Queue") == 0) {
-    return ParserQueue::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CommandPool") == 0) {
-    return ParserCommandPool::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CommandBuffer") == 0) {
-    return ParserCommandBuffer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Fence") == 0) {
-    return ParserFence::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Buffer") == 0) {
-    return ParserBuffer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BufferLoader") == 0) {
-    return ParserBufferLoader::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Image") == 0) {
-    return ParserImage::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ImageLoader") == 0) {
-    return ParserImageLoader::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ImageView") == 0) {
-    return ParserImageView::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Swapchain") == 0) {
-    return ParserSwapchain::Get().ParseElement(element, status);
-  } else if (strcmp(name, "RenderPass") == 0) {
-    return ParserRenderPass::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Multiview") == 0) {
-    return ParserMultiview::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Attachment") == 0) {
-    return ParserAttachment::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Subpass") == 0) {
-    return ParserSubpass::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ColorAttachment") == 0) {
-    return ParserColorAttachment::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DepthStencilAttachment") == 0) {
-    return ParserDepthStencilAttachment::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Dependency") == 0) {
-    return ParserDependency::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ShaderModule") == 0) {
-    return ParserShaderModule::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DescriptorSetLayout") == 0) {
-    return ParserDescriptorSetLayout::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DescriptorSetLayoutBinding") == 0) {
-    return ParserDescriptorSetLayoutBinding::Get().ParseElement(element,
-                                                                status);
-  } else if (strcmp(name, "PipelineLayout") == 0) {
-    return ParserPipelineLayout::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ComputePipeline") == 0) {
-    return ParserComputePipeline::Get().ParseElement(element, status);
-  } else if (strcmp(name, "GraphicsPipeline") == 0) {
-    return ParserGraphicsPipeline::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Stage") == 0) {
-    return ParserStage::Get().ParseElement(element, status);
-  } else if (strcmp(name, "SpecializationInfo") == 0) {
-    return ParserSpecializationInfo::Get().ParseElement(element, status);
-  } else if (strcmp(name, "VertexInputState") == 0) {
-    return ParserVertexInputState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "VertexBindingDescription") == 0) {
-    return ParserVertexBindingDescription::Get().ParseElement(element, status);
-  } else if (strcmp(name, "VertexAttributeDescription") == 0) {
-    return ParserVertexAttributeDescription::Get().ParseElement(element,
-                                                                status);
-  } else if (strcmp(name, "InputAssemblyState") == 0) {
-    return ParserInputAssemblyState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ViewportState") == 0) {
-    return ParserViewportState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Viewport") == 0) {
-    return ParserViewport::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Scissor") == 0) {
-    return ParserScissor::Get().ParseElement(element, status);
-  } else if (strcmp(name, "RasterizationState") == 0) {
-    return ParserRasterizationState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "MultisampleState") == 0) {
-    return ParserMultisampleState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DepthStencilState") == 0) {
-    return ParserDepthStencilState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ColorBlendState") == 0) {
-    return ParserColorBlendState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DynamicState") == 0) {
-    return ParserDynamicState::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DescriptorPool") == 0) {
-    return ParserDescriptorPool::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DescriptorSet") == 0) {
-    return ParserDescriptorSet::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Descriptor") == 0) {
-    return ParserDescriptor::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ImageInfo") == 0) {
-    return ParserDescriptorImageInfo::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BufferInfo") == 0) {
-    return ParserDescriptorBufferInfo::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Frame") == 0) {
-    return ParserFrame::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Framebuffer") == 0) {
-    return ParserFramebuffer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Semaphore") == 0) {
-    return ParserSemaphore::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Sampler") == 0) {
-    return ParserSampler::Get().ParseElement(element, status);
-  } else if (strcmp(name, "QueryPool") == 0) {
-    return ParserQueryPool::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Event") == 0) {
-    return ParserEvent::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Camera") == 0) {
-    return ParserCamera::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CommandGroup") == 0) {
-    return ParserCommandGroup::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CommandList") == 0) {
-    return ParserCommandList::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CommandContext") == 0) {
-    return ParserCommandContext::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Function") == 0) {
-    return ParserFunction::Get().ParseElement(element, status);
-  } else if (strcmp(name, "PipelineBarrier") == 0) {
-    return ParserPipelineBarrier::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BufferMemoryBarrier") == 0) {
-    return ParserBufferMemoryBarrier::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ImageMemoryBarrier") == 0) {
-    return ParserImageMemoryBarrier::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CopyBuffer") == 0) {
-    return ParserCopyBuffer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Dispatch") == 0) {
-    return ParserDispatch::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BeginRenderPass") == 0) {
-    return ParserBeginRenderPass::Get().ParseElement(element, status);
-  } else if (strcmp(name, "EndRenderPass") == 0) {
-    return ParserEndRenderPass::Get().ParseElement(element, status);
-  } else if (strcmp(name, "SetViewport") == 0) {
-    return ParserSetViewport::Get().ParseElement(element, status);
-  } else if (strcmp(name, "SetScissor") == 0) {
-    return ParserSetScissor::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BindDescriptorSets") == 0) {
-    return ParserBindDescriptorSets::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BindPipeline") == 0) {
-    return ParserBindPipeline::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BindVertexBuffers") == 0) {
-    return ParserBindVertexBuffers::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BindIndexBuffer") == 0) {
-    return ParserBindIndexBuffer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Draw") == 0) {
-    return ParserDraw::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DrawIndexed") == 0) {
-    return ParserDrawIndexed::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DrawIndexedIndirect") == 0) {
-    return ParserDrawIndexedIndirect::Get().ParseElement(element, status);
-  } else if (strcmp(name, "BlitImage") == 0) {
-    return ParserBlitImage::Get().ParseElement(element, status);
-  } else if (strcmp(name, "PushConstants") == 0) {
-    return ParserPushConstants::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ResetQueryPool") == 0) {
-    return ParserResetQueryPool::Get().ParseElement(element, status);
-  } else if (strcmp(name, "SetEvent") == 0) {
-    return ParserSetEvent::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ResetEvent") == 0) {
-    return ParserResetEvent::Get().ParseElement(element, status);
-  } else if (strcmp(name, "NextSubpass") == 0) {
-    return ParserNextSubpass::Get().ParseElement(element, status);
-  } else if (strcmp(name, "DrawOverlay") == 0) {
-    return ParserDrawOverlay::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Overlay") == 0) {
-    return ParserOverlay::Get().ParseElement(element, status);
-  } else if (strcmp(name, "WindowViewer") == 0) {
-    return ParserWindowViewer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "AcquireNextImage") == 0) {
-    return ParserAcquireNextImage::Get().ParseElement(element, status);
-  } else if (strcmp(name, "QueueSubmit") == 0) {
-    return ParserQueueSubmit::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Submit") == 0) {
-    return ParserSubmit::Get().ParseElement(element, status);
-  } else if (strcmp(name, "QueuePresent") == 0) {
-    return ParserQueuePresent::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Resizer") == 0) {
-    return ParserResizer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Updater") == 0) {
-    return ParserUpdater::Get().ParseElement(element, status);
-  }
+  using ParseElementFunc = bool (*)(const tinyxml2::XMLElement*,
+                                    ParserStatus*);
+  static constexpr auto mapping = MakeStringTable<ParseElementFunc>({
+#define ENTRY(s) {#s, ParseElementWith<Parser##s>}
+      ENTRY(Engine),
+      ENTRY(Constant),
+      ENTRY(Data),
+      ENTRY(ResourceLoader),
+      ENTRY(Renderer),
+      ENTRY(Window),
+      ENTRY(Device),
+      ENTRY(Queue),
+      ENTRY(CommandPool),
+      ENTRY(CommandBuffer),
+      ENTRY(Fence),
+      ENTRY(Buffer),
+      ENTRY(BufferLoader),
+      ENTRY(Image),
+      ENTRY(ImageLoader),
+      ENTRY(ImageView),
+      ENTRY(Swapchain),
+      ENTRY(RenderPass),
+      ENTRY(Multiview),
+      ENTRY(Attachment),
+      ENTRY(Subpass),
+      ENTRY(ColorAttachment),
+      ENTRY(DepthStencilAttachment),
+      ENTRY(Dependency),
+      ENTRY(ShaderModule),
+      ENTRY(DescriptorSetLayout),
+      ENTRY(DescriptorSetLayoutBinding),
+      ENTRY(PipelineLayout),
+      ENTRY(ComputePipeline),
+      ENTRY(GraphicsPipeline),
+      ENTRY(Stage),
+      ENTRY(SpecializationInfo),
+      ENTRY(VertexInputState),
+      ENTRY(VertexBindingDescription),
+      ENTRY(VertexAttributeDescription),
+      ENTRY(InputAssemblyState),
+      ENTRY(ViewportState),
+      ENTRY(Viewport),
+      ENTRY(Scissor),
+      ENTRY(RasterizationState),
+      ENTRY(MultisampleState),
+      ENTRY(DepthStencilState),
+      ENTRY(ColorBlendState),
+      ENTRY(DynamicState),
+      ENTRY(DescriptorPool),
+      ENTRY(DescriptorSet),
+      ENTRY(Descriptor),
+      {"ImageInfo", ParseElementWith<ParserDescriptorImageInfo>},
+      {"BufferInfo", ParseElementWith<ParserDescriptorBufferInfo>},
+      ENTRY(Frame),
+      ENTRY(Framebuffer),
+      ENTRY(Semaphore),
+      ENTRY(Sampler),
+      ENTRY(QueryPool),
+      ENTRY(Event),
+      ENTRY(Camera),
+      ENTRY(CommandGroup),
+      ENTRY(CommandList),
+      ENTRY(CommandContext),
+      ENTRY(Function),
+      ENTRY(PipelineBarrier),
+      ENTRY(BufferMemoryBarrier),
+      ENTRY(ImageMemoryBarrier),
+      ENTRY(CopyBuffer),
+      ENTRY(Dispatch),
+      ENTRY(BeginRenderPass),
+      ENTRY(EndRenderPass),
+      ENTRY(SetViewport),
+      ENTRY(SetScissor),
+      ENTRY(BindDescriptorSets),
+      ENTRY(BindPipeline),
+      ENTRY(BindVertexBuffers),
+      ENTRY(BindIndexBuffer),
+      ENTRY(Draw),
+      ENTRY(DrawIndexed),
+      ENTRY(DrawIndexedIndirect),
+      ENTRY(BlitImage),
+      ENTRY(PushConstants),
+      ENTRY(ResetQueryPool),
+      ENTRY(SetEvent),
+      ENTRY(ResetEvent),
+      ENTRY(NextSubpass),
+      ENTRY(DrawOverlay),
+      ENTRY(Overlay),
+      ENTRY(WindowViewer),
+      ENTRY(AcquireNextImage),
+      ENTRY(QueueSubmit),
+      ENTRY(Submit),
+      ENTRY(QueuePresent),
+      ENTRY(Resizer),
+      ENTRY(Updater),
 #ifdef XG_ENABLE_REALITY
-  else if (strcmp(name, "Reality") == 0) {
-    return ParserReality::Get().ParseElement(element, status);
-  } else if (strcmp(name, "Session") == 0) {
-    return ParserSession::Get().ParseElement(element, status);
-  } else if (strcmp(name, "ReferenceSpace") == 0) {
-    return ParserReferenceSpace::Get().ParseElement(element, status);
-  } else if (strcmp(name, "CompositionLayerProjection") == 0) {
-    return ParserCompositionLayerProjection::Get().ParseElement(element,
-                                                                status);
-  } else if (strcmp(name, "RealityViewer") == 0) {
-    return ParserRealityViewer::Get().ParseElement(element, status);
-  } else if (strcmp(name, "View") == 0) {
-    return ParserView::Get().ParseElement(element, status);
-  } else if (strcmp(name, "LocateSpace") == 0) {
-    return ParserLocateSpace::Get().ParseElement(element, status);
-  } else if (strcmp(name, "EndFrame") == 0) {
-    return ParserEndFrame::Get().ParseElement(element, status);
-  }
+      ENTRY(Reality),
+      ENTRY(Session),
+      ENTRY(ReferenceSpace),
+      ENTRY(CompositionLayerProjection),
+      ENTRY(RealityViewer),
+      ENTRY(View),
+      ENTRY(LocateSpace),
+      ENTRY(EndFrame),
 #endif  // XG_ENABLE_REALITY
+#undef ENTRY
+  });
+
+  const char* name = element->Name();
+
+  const auto x = mapping.find(name);
+  if (x != std::end(mapping)) return x->second(element, status);
 
   XG_ERROR("unknown element: {}", name);
   return false;
 }
 
-std::shared_ptr<Layout> Parser::ParseFile(const std::string& xml_path) {
-  std::vector<uint8_t> xml;
-
-  XG_TRACE("ParseFile: {}", xml_path);
+static bool ParseSubtree(const tinyxml2::XMLElement* element,
+                         std::shared_ptr<LayoutBase> parent,
+                         std::vector<std::shared_ptr<LayoutBase>>* nodes);
+
+static void Substitute(tinyxml2::XMLNode* node, const std::string& pattern,
+                       const std::string& replacement) {
+  const auto replace = [&pattern, &replacement](const char* value) {
+    std::string result(value);
+    for (auto pos = result.find(pattern); pos != std::string::npos;
+         pos = result.find(pattern, pos + replacement.size())) {
+      result.replace(pos, pattern.size(), replacement);
+    }
+    return result;
+  };
+
+  auto element = node->ToElement();
+  if (element) {
+    for (auto attribute = element->FirstAttribute(); attribute;
+         attribute = attribute->Next()) {
+      if (std::strstr(attribute->Value(), pattern.c_str())) {
+        element->SetAttribute(attribute->Name(),
+                              replace(attribute->Value()).c_str());
+      }
+    }
+  } else if (node->ToText() && std::strstr(node->Value(), pattern.c_str())) {
+    node->SetValue(replace(node->Value()).c_str());
+  }
 
-  if (!LoadFile(xml_path, &xml)) return nullptr;
+  for (auto child = node->FirstChild(); child; child = child->NextSibling()) {
+    Substitute(child, pattern, replacement);
+  }
+}
 
-  tinyxml2::XMLDocument doc;
-  const auto err = doc.Parse(reinterpret_cast<char*>(xml.data()), xml.size());
-  if (err != tinyxml2::XML_SUCCESS) {
-    XG_ERROR("parse layout file error: {}", Tinyxml2ErrorString(err));
-    return nullptr;
+// <Repeat count="N" var="i"> instantiates its children N times, with {i}
+// replaced by the instance index in their attributes and text. The template
+// is cloned from the parsed document, so its text is parsed only once. The
+// parsed nodes keep only interned ids, so each instance is deleted once it
+// is parsed and the next one reuses its memory.
+static constexpr int64_t kMaxRepeatCount = 1 << 20;
+
+static bool ParseRepeat(const tinyxml2::XMLElement* element,
+                        std::shared_ptr<LayoutBase> parent,
+                        std::vector<std::shared_ptr<LayoutBase>>* nodes) {
+  const char* value = element->Attribute("count");
+  if (!value) {
+    XG_ERROR("repeat count not specified");
+    return false;
   }
 
-  auto layout = std::make_shared<Layout>();
-  if (!layout) {
-    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
-    return nullptr;
+  int64_t count = 0;
+  if (!StringToLiteral(value, &count)) {
+    const auto evaluated = Expression::Get().Evaluate(value);
+    count = evaluated >= 0.0f && evaluated <= kMaxRepeatCount
+                ? static_cast<int64_t>(evaluated)
+                : -1;
+  }
+  if (count < 0 || count > kMaxRepeatCount) {
+    XG_ERROR("invalid repeat count: {}", value);
+    return false;
   }
 
-  Expression::Get().Reset();
+  value = element->Attribute("var");
+  const auto pattern = std::string("{") + (value ? value : "i") + "}";
 
+  // each repeat owns the document of its instances, so repeats parsed in
+  // parallel do not share a tinyxml2 memory pool
+  tinyxml2::XMLDocument doc;
+
+  for (int64_t i = 0; i < count; ++i) {
+    const auto index = std::to_string(i);
+
+    for (auto child = element->FirstChildElement(); child;
+         child = child->NextSiblingElement()) {
+      auto instance = doc.InsertEndChild(child->DeepClone(&doc));
+      Substitute(instance, pattern, index);
+      const auto result = ParseSubtree(instance->ToElement(), parent, nodes);
+      doc.DeleteNode(instance);
+      if (!result) return false;
+    }
+  }
+  return true;
+}
+
+// Parses |element| and its descendants, but not its siblings, and appends
+// the created nodes in document order. Fails if a repeat in it is invalid.
+static bool ParseSubtree(const tinyxml2::XMLElement* element,
+                         std::shared_ptr<LayoutBase> parent,
+                         std::vector<std::shared_ptr<LayoutBase>>* nodes) {
   std::stack<ParserStatus> tree_stack;
   ParserStatus status;
 
-  status.element = doc.RootElement();
+  status.parent = parent;
+  status.element = element;
   tree_stack.push(status);
 
   // non-recursive parsing xml
@@ -280,10 +267,11 @@ std::shared_ptr<Layout> Parser::ParseFile(const std::string& xml_path) {
     if (status.node == nullptr) {
       assert(status.child_element == nullptr);
 
-      bool result = ParseElement(status.element, &status);
-      if (result) {
+      if (std::strcmp(status.element->Name(), "Repeat") == 0) {
+        if (!ParseRepeat(status.element, status.parent, nodes)) return false;
+      } else if (ParseElement(status.element, &status)) {
         assert(status.node);
-        AddLayoutNode(layout, status.node);
+        nodes->emplace_back(status.node);
 
         tree_stack.push(status);
 
@@ -297,6 +285,8 @@ std::shared_ptr<Layout> Parser::ParseFile(const std::string& xml_path) {
         continue;
       }
     }
+    if (status.element == element) continue;
+
     status.element = status.element->NextSiblingElement();
     if (status.element != nullptr) {
       status.node = nullptr;
@@ -304,11 +294,592 @@ std::shared_ptr<Layout> Parser::ParseFile(const std::string& xml_path) {
       tree_stack.push(status);
     }
   }
-  ResolveLayoutReferences(layout);
+  return true;
+}
+
+class ParseSubtreesTask : public Task {
+ public:
+  using Subtree = std::pair<const tinyxml2::XMLElement*,
+                            std::vector<std::shared_ptr<LayoutBase>>>;
+
+  ParseSubtreesTask(std::shared_ptr<LayoutBase> parent,
+                    std::vector<Subtree*> subtrees)
+      : context_(ParseContext::GetCurrent()),
+        parent_(std::move(parent)),
+        subtrees_(std::move(subtrees)) {}
+
+  void Run(std::shared_ptr<Task> self) override {
+    ParseContext::Scope scope(context_);
+    for (auto* subtree : subtrees_) {
+      if (!ParseSubtree(subtree->first, parent_, &subtree->second)) {
+        failed_ = true;
+        break;
+      }
+    }
+    barrier_.set_value(nullptr);
+  }
+
+  // valid once finished
+  bool IsFailed() const { return failed_; }
+
+ private:
+  ParseContext* context_;
+  std::shared_ptr<LayoutBase> parent_;
+  std::vector<Subtree*> subtrees_;
+  bool failed_ = false;
+};
+
+// An included fragment is an <Engine> document whose children are added to
+// the including layout. It is parsed with a context of its own, so it sees
+// only its own constants and refers only to its own nodes, which makes its
+// nodes the same for every layout that includes it. They are cached per
+// process by the hash of the content and shared by those layouts.
+static constexpr int kMaxIncludeDepth = 16;
+static constexpr size_t kMaxCachedFragments = 64;
+
+struct LayoutFragment {
+  ParseContext context;  // the ids of the nodes are interned in it
+  std::vector<std::shared_ptr<LayoutBase>> nodes;
+  std::vector<std::string> dependencies;
+};
+
+// The most recently included fragments. An evicted fragment is still kept
+// by the parses that are using it.
+class FragmentCache {
+ public:
+  static FragmentCache& Get() {
+    static FragmentCache cache;
+    return cache;
+  }
+
+  std::shared_ptr<LayoutFragment> Find(uint64_t hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = index_.find(hash);
+    if (it == index_.end()) return nullptr;
+
+    fragments_.splice(fragments_.begin(), fragments_, it->second);
+    return it->second->second;
+  }
+
+  // Returns the fragment another parse added meanwhile if there is one.
+  std::shared_ptr<LayoutFragment> Add(
+      uint64_t hash, std::shared_ptr<LayoutFragment> fragment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = index_.find(hash);
+    if (it != index_.end()) return it->second->second;
+
+    fragments_.emplace_front(hash, std::move(fragment));
+    index_.emplace(hash, fragments_.begin());
+    if (fragments_.size() > kMaxCachedFragments) {
+      index_.erase(fragments_.back().first);
+      fragments_.pop_back();
+    }
+    return fragments_.front().second;
+  }
+
+ private:
+  using Entry = std::pair<uint64_t, std::shared_ptr<LayoutFragment>>;
+
+  FragmentCache() = default;
+
+  std::mutex mutex_;
+  std::list<Entry> fragments_;  // most recently used first
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+static bool ParseInclude(const tinyxml2::XMLElement* element,
+                         std::shared_ptr<LayoutBase> parent, int depth,
+                         std::vector<std::shared_ptr<LayoutBase>>* nodes);
+
+// The nodes the layout links to itself when its references are resolved
+// belong to a single layout.
+static bool IsLayoutNode(LayoutType layout_type) {
+  switch (layout_type) {
+    case LayoutType::kRenderer:
+    case LayoutType::kResourceLoader:
+    case LayoutType::kWindow:
+    case LayoutType::kDevice:
+    case LayoutType::kQueue:
+#ifdef XG_ENABLE_REALITY
+    case LayoutType::kReality:
+    case LayoutType::kSession:
+#endif  // XG_ENABLE_REALITY
+      return true;
+    default:
+      return false;
+  }
+}
+
+static std::shared_ptr<LayoutFragment> ParseFragment(
+    const char* file, const MappedFile& mapped_file,
+    std::shared_ptr<LayoutBase> parent, int depth) {
+  XG_TRACE("include fragment: {}", file);
+
+  auto fragment = std::make_shared<LayoutFragment>();
+  if (!fragment) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  tinyxml2::XMLDocument doc;
+  const auto err =
+      doc.Parse(reinterpret_cast<const char*>(mapped_file.GetData()),
+                mapped_file.GetSize());
+  if (err != tinyxml2::XML_SUCCESS) {
+    XG_ERROR("parse fragment file error: {}", Tinyxml2ErrorString(err));
+    return nullptr;
+  }
+
+  ParseContext::Scope scope(&fragment->context);
+
+  for (auto child = doc.RootElement()->FirstChildElement(); child;
+       child = child->NextSiblingElement()) {
+    if (strcmp(child->Name(), "Include") == 0) {
+      if (!ParseInclude(child, parent, depth + 1, &fragment->nodes)) {
+        return nullptr;
+      }
+    } else if (!ParseSubtree(child, parent, &fragment->nodes)) {
+      return nullptr;
+    }
+  }
+
+  for (const auto& node : fragment->nodes) {
+    if (IsLayoutNode(node->layout_type)) {
+      XG_ERROR("fragment cannot hold layout node: {}", file);
+      return nullptr;
+    }
+    if (!node->id.empty()) fragment->context.AddNode(node);
+  }
+  if (!fragment->context.ResolveReferences()) {
+    XG_ERROR("fragment refers to nodes outside it: {}", file);
+    return nullptr;
+  }
+
+  fragment->dependencies = fragment->context.GetDependencies().GetFiles();
+  return fragment;
+}
+
+static bool ParseInclude(const tinyxml2::XMLElement* element,
+                         std::shared_ptr<LayoutBase> parent, int depth,
+                         std::vector<std::shared_ptr<LayoutBase>>* nodes) {
+  assert(element);
+  assert(nodes);
+
+  const char* file = element->Attribute("file");
+  if (!file) {
+    XG_ERROR("include file not specified");
+    return false;
+  }
+
+  if (depth >= kMaxIncludeDepth) {
+    XG_ERROR("include depth exceeded: {}", file);
+    return false;
+  }
+
+  const auto mapped_file = MappedFile::Open(file);
+  if (!mapped_file) return false;
+
+  auto& cache = FragmentCache::Get();
+  const auto hash = HashData(mapped_file->GetData(), mapped_file->GetSize());
+  auto fragment = cache.Find(hash);
+  if (fragment) {
+    XG_TRACE("include cached fragment: {}", file);
+  } else {
+    fragment = ParseFragment(file, *mapped_file, parent, depth);
+    if (!fragment) return false;
+    fragment = cache.Add(hash, std::move(fragment));
+  }
+
+  auto context = ParseContext::GetCurrent();
+  context->KeepFragment(fragment);
+
+  auto& dependencies = context->GetDependencies();
+  dependencies.Add(file);
+  for (const auto& dependency : fragment->dependencies) {
+    dependencies.Add(dependency.c_str());
+  }
+
+  // the constants of the fragment are used by the rest of the layout
+  for (const auto& node : fragment->nodes) {
+    if (node->layout_type == LayoutType::kConstant) {
+      const auto lconstant = static_cast<LayoutConstant*>(node.get());
+      context->GetExpression().AddConstant(lconstant->id.c_str(),
+                                           lconstant->value);
+    }
+  }
+  nodes->insert(nodes->end(), fragment->nodes.begin(), fragment->nodes.end());
+
+  return true;
+}
+
+// Streamed layouts are parsed in batches of top level elements, each batch
+// being a small document that is freed once it is parsed.
+static constexpr size_t kStreamBatchSize = 1 << 20;
+
+static std::string MakeEmptyElement(std::string_view start_tag) {
+  std::string tag(start_tag);
+  if (tag.size() < 2 || tag[tag.size() - 2] != '/') {
+    tag.insert(tag.size() - 1, "/");
+  }
+  return tag;
+}
+
+// Only the start tag of a streamed <Data> goes through tinyxml2. Its values
+// are decoded straight from the mapped file and do not need to be kept.
+static std::shared_ptr<LayoutBase> ParseStreamData(
+    const XmlStream::Element& element, std::shared_ptr<LayoutBase> parent) {
+  const auto start_tag = MakeEmptyElement(element.start_tag);
+
+  tinyxml2::XMLDocument doc;
+  const auto err = doc.Parse(start_tag.data(), start_tag.size());
+  if (err != tinyxml2::XML_SUCCESS) {
+    XG_ERROR("parse data element error: {}", Tinyxml2ErrorString(err));
+    return nullptr;
+  }
+
+  ParserStatus status;
+  status.parent = parent;
+  status.element = doc.RootElement();
+  if (!ParseElement(status.element, &status)) return nullptr;
+
+  auto ldata = std::static_pointer_cast<LayoutData>(status.node);
+  if (ldata->file.empty()) {
+    XmlStream values(element.content);
+    XmlStream::Element value;
+    std::vector<uint8_t> data;
+
+    while (values.ReadElement(&value)) {
+      if (value.name != "Generate") {
+        AppendDataValues(value.name, value.content, &data);
+        continue;
+      }
+
+      const auto generate = MakeEmptyElement(value.start_tag);
+      tinyxml2::XMLDocument generate_doc;
+      if (generate_doc.Parse(generate.data(), generate.size()) !=
+              tinyxml2::XML_SUCCESS ||
+          !AppendGeneratedValues(generate_doc.RootElement(), &data)) {
+        return nullptr;
+      }
+    }
+    if (values.IsError()) return nullptr;
+
+    ldata->data = ParseContext::GetCurrent()->InternBlob(
+        std::make_shared<LayoutBlob>(std::move(data)));
+  }
+
+  return ldata;
+}
+
+std::shared_ptr<Layout> Parser::ParseFile(
+    const std::string& xml_path, ParseMode mode,
+    std::vector<std::string>* dependencies) {
+  ParseContext context;
+  ParseContext::Scope scope(&context);
+
+  std::string cache_path;
+  if (!cache_dir_.empty()) {
+    cache_path = GetLayoutCachePath(cache_dir_, xml_path);
+    if (!cache_path.empty()) {
+      auto layout = LoadCachedLayout(cache_path);
+      if (layout) return layout;
+    }
+  }
+
+  auto layout = mode == ParseMode::kStream ? ParseStream(xml_path)
+                                           : ParseDocument(xml_path);
+
+  if (layout && !cache_path.empty()) {
+    SaveCachedLayout(cache_path, layout,
+                     context.GetDependencies().GetFiles());
+  }
+  if (layout && dependencies) {
+    *dependencies = context.GetDependencies().GetFiles();
+  }
+
+  return layout;
+}
+
+class ParseFileTask : public Task {
+ public:
+  ParseFileTask(std::string xml_path, ParseMode mode)
+      : xml_path_(std::move(xml_path)), mode_(mode) {}
+
+  void Run(std::shared_ptr<Task> self) override {
+    layout_ = Parser::Get().ParseFile(xml_path_, mode_);
+    barrier_.set_value(nullptr);
+  }
+
+  std::shared_ptr<Layout> GetLayout() const { return layout_; }
+
+ private:
+  std::string xml_path_;
+  ParseMode mode_;
+  std::shared_ptr<Layout> layout_;
+};
+
+std::vector<std::shared_ptr<Layout>> Parser::ParseFiles(
+    const std::vector<std::string>& xml_paths, ParseMode mode) {
+  std::vector<std::shared_ptr<Layout>> layouts;
+  auto& thread_pool = ThreadPool::Get();
+
+  if (thread_pool.IsWorkerThread()) {
+    for (const auto& xml_path : xml_paths) {
+      layouts.emplace_back(ParseFile(xml_path, mode));
+    }
+    return layouts;
+  }
+
+  std::vector<std::shared_ptr<ParseFileTask>> tasks;
+  for (const auto& xml_path : xml_paths) {
+    const auto& task = std::make_shared<ParseFileTask>(xml_path, mode);
+    tasks.emplace_back(task);
+    thread_pool.Post(ThreadPool::Job(task));
+  }
+
+  for (const auto& task : tasks) {
+    task->Finish();
+    layouts.emplace_back(task->GetLayout());
+  }
+
+  return layouts;
+}
+
+std::shared_ptr<Layout> Parser::ParseDocument(const std::string& xml_path) {
+  XG_TRACE("ParseDocument: {}", xml_path);
+
+  const auto xml = MappedFile::Open(xml_path);
+  if (!xml) return nullptr;
+
+  tinyxml2::XMLDocument doc;
+  const auto err = doc.Parse(reinterpret_cast<const char*>(xml->GetData()),
+                             xml->GetSize());
+  if (err != tinyxml2::XML_SUCCESS) {
+    XG_ERROR("parse layout file error: {}", Tinyxml2ErrorString(err));
+    return nullptr;
+  }
+
+  auto layout = std::make_shared<Layout>();
+  if (!layout) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  ParserStatus status;
+  status.element = doc.RootElement();
+
+  if (ParseElement(status.element, &status)) {
+    assert(status.node);
+    AddLayoutNode(layout, status.node);
+    if (!ParseChildren(layout, status.node, status.child_element)) {
+      return nullptr;
+    }
+  }
+  if (parsed_handler_) parsed_handler_(*layout);
+  if (!ResolveLayoutReferences(layout)) return nullptr;
+
+  XG_DEBUG("expression cache hits: {} misses: {}, deduplicated bytes: {}",
+           Expression::Get().GetCacheHits(),
+           Expression::Get().GetCacheMisses(),
+           ParseContext::GetCurrent()->GetSavedBlobBytes());
+
+  return layout;
+}
+
+std::shared_ptr<Layout> Parser::ParseStream(const std::string& xml_path) {
+  XG_TRACE("ParseStream: {}", xml_path);
+
+  const auto mapped_file = MappedFile::Open(xml_path);
+  if (!mapped_file) return nullptr;
+
+  auto layout = std::make_shared<Layout>();
+  if (!layout) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return nullptr;
+  }
+
+  XmlStream stream(
+      std::string_view(reinterpret_cast<const char*>(mapped_file->GetData()),
+                       mapped_file->GetSize()));
+  XmlStream::Element root;
+  if (!stream.ReadRoot(&root)) return nullptr;
+
+  const auto root_tag = MakeEmptyElement(root.start_tag);
+  tinyxml2::XMLDocument root_doc;
+  auto err = root_doc.Parse(root_tag.data(), root_tag.size());
+  if (err != tinyxml2::XML_SUCCESS) {
+    XG_ERROR("parse layout file error: {}", Tinyxml2ErrorString(err));
+    return nullptr;
+  }
+
+  ParserStatus status;
+  status.element = root_doc.RootElement();
+  if (!ParseElement(status.element, &status)) return nullptr;
+
+  auto parent = status.node;
+  assert(parent);
+  AddLayoutNode(layout, parent);
+
+  const auto batch_begin = "<" + std::string(root.name) + ">";
+  const auto batch_end = "</" + std::string(root.name) + ">";
+  std::string batch = batch_begin;
+  size_t batch_count = 0;
+
+  const auto flush = [&]() {
+    if (batch.size() == batch_begin.size()) return true;
+    batch.append(batch_end);
+
+    tinyxml2::XMLDocument doc;
+    err = doc.Parse(batch.data(), batch.size());
+    if (err != tinyxml2::XML_SUCCESS) {
+      XG_ERROR("parse layout file error: {}", Tinyxml2ErrorString(err));
+      return false;
+    }
+
+    if (!ParseChildren(layout, parent,
+                       doc.RootElement()->FirstChildElement())) {
+      return false;
+    }
+    ++batch_count;
+    batch.resize(batch_begin.size());
+
+    return true;
+  };
+
+  XmlStream::Element element;
+  size_t discarded = 0;
+
+  while (stream.ReadElement(&element)) {
+    if (element.name == "Data" && !element.empty) {
+      // earlier constants may be used by the values
+      if (!flush()) return nullptr;
+
+      auto ldata = ParseStreamData(element, parent);
+      if (!ldata) return nullptr;
+      AddLayoutNode(layout, ldata);
+    } else {
+      batch.append(element.text);
+      if (batch.size() >= kStreamBatchSize && !flush()) return nullptr;
+    }
+
+    if (stream.GetOffset() - discarded >= kStreamBatchSize) {
+      mapped_file->Discard(discarded, stream.GetOffset() - discarded);
+      discarded = stream.GetOffset();
+    }
+  }
+  if (stream.IsError() || !flush()) return nullptr;
+
+  if (parsed_handler_) parsed_handler_(*layout);
+  if (!ResolveLayoutReferences(layout)) return nullptr;
+
+  XG_DEBUG(
+      "streamed {} batches, expression cache hits: {} misses: {}, "
+      "deduplicated bytes: {}",
+      batch_count, Expression::Get().GetCacheHits(),
+      Expression::Get().GetCacheMisses(),
+      ParseContext::GetCurrent()->GetSavedBlobBytes());
 
   return layout;
 }
 
+// Parses the subtrees, spread over the workers when there are several.
+static bool ParseSubtrees(std::shared_ptr<LayoutBase> parent,
+                          ParseSubtreesTask::Subtree* begin,
+                          ParseSubtreesTask::Subtree* end) {
+  // data generated from expressions is split across the workers by itself,
+  // which it can only do from the calling thread, so it is parsed there
+  // while the workers parse the other subtrees
+  std::vector<ParseSubtreesTask::Subtree*> pending;
+  std::vector<ParseSubtreesTask::Subtree*> generated;
+  for (auto subtree = begin; subtree != end; ++subtree) {
+    if (strcmp(subtree->first->Name(), "Data") == 0 &&
+        subtree->first->FirstChildElement("Generate")) {
+      generated.emplace_back(subtree);
+    } else {
+      pending.emplace_back(subtree);
+    }
+  }
+
+  // a parse running on a worker does not wait on other workers, which may
+  // all be parsing too
+  auto& thread_pool = ThreadPool::Get();
+  const auto task_count =
+      thread_pool.IsWorkerThread()
+          ? 0
+          : std::min(thread_pool.GetWorkerCount(), pending.size());
+
+  if (task_count > 1) {
+    std::vector<std::shared_ptr<ParseSubtreesTask>> tasks;
+    const auto per_task = (pending.size() + task_count - 1) / task_count;
+
+    for (size_t i = 0; i < pending.size(); i += per_task) {
+      const auto task_end = std::min(i + per_task, pending.size());
+      const auto& task = std::make_shared<ParseSubtreesTask>(
+          parent, std::vector<ParseSubtreesTask::Subtree*>(
+                      pending.begin() + i, pending.begin() + task_end));
+      tasks.emplace_back(task);
+      thread_pool.Post(ThreadPool::Job(task));
+    }
+    bool result = true;
+    for (auto* subtree : generated) {
+      if (!ParseSubtree(subtree->first, parent, &subtree->second)) {
+        result = false;
+        break;
+      }
+    }
+    for (const auto& task : tasks) {
+      task->Finish();
+      if (task->IsFailed()) result = false;
+    }
+    return result;
+  }
+
+  for (auto* subtree : generated) {
+    if (!ParseSubtree(subtree->first, parent, &subtree->second)) return false;
+  }
+  for (auto* subtree : pending) {
+    if (!ParseSubtree(subtree->first, parent, &subtree->second)) return false;
+  }
+  return true;
+}
+
+bool Parser::ParseChildren(std::shared_ptr<Layout> layout,
+                           std::shared_ptr<LayoutBase> parent,
+                           const tinyxml2::XMLElement* first_child) {
+  assert(layout);
+
+  std::vector<ParseSubtreesTask::Subtree> subtrees;
+  for (auto child = first_child; child; child = child->NextSiblingElement()) {
+    subtrees.emplace_back(child, std::vector<std::shared_ptr<LayoutBase>>());
+  }
+
+  // a constant is visible to the expressions after it only, so constants
+  // and the includes that may define them are parsed in document order, and
+  // the subtrees between them are parsed together
+  auto begin = subtrees.data();
+  const auto end = subtrees.data() + subtrees.size();
+  for (auto subtree = begin; subtree != end; ++subtree) {
+    const char* name = subtree->first->Name();
+    const bool constant = strcmp(name, "Constant") == 0;
+    const bool include = strcmp(name, "Include") == 0;
+    if (!constant && !include) continue;
+
+    if (!ParseSubtrees(parent, begin, subtree)) return false;
+    const auto result =
+        constant ? ParseSubtree(subtree->first, parent, &subtree->second)
+                 : ParseInclude(subtree->first, parent, 0, &subtree->second);
+    if (!result) return false;
+    begin = subtree + 1;
+  }
+  if (!ParseSubtrees(parent, begin, end)) return false;
+
+  // merge in document order
+  for (const auto& subtree : subtrees) {
+    for (const auto& node : subtree.second) AddLayoutNode(layout, node);
+  }
+  return true;
+}
+
 void Parser::AddLayoutNode(std::shared_ptr<Layout> layout,
                            std::shared_ptr<LayoutBase> node) {
   assert(layout);
@@ -320,6 +891,7 @@ void Parser::AddLayoutNode(std::shared_ptr<Layout> layout,
       return;
     }
     layout->node_id_map.insert(std::make_pair(node->id, node));
+    ParseContext::GetCurrent()->AddNode(node);
   }
 
   switch (node->layout_type) {
@@ -649,9 +1221,32 @@ void Parser::AddLayoutNode(std::shared_ptr<Layout> layout,
   }
 }
 
-void Parser::ResolveLayoutReferences(std::shared_ptr<Layout> layout) {
+template <typename T>
+static int FindIndex(const std::vector<std::shared_ptr<T>>& nodes,
+                     const char* id) {
+  for (auto i = 0; i < nodes.size(); ++i) {
+    if (nodes[i]->id == id) return i;
+  }
+  return -1;
+}
+
+static void ResolveSpecializationInfo(LayoutSpecializationInfo* lspec_info) {
+  size_t data_size = 0;
+  for (const auto& map_entry : lspec_info->map_entries) {
+    data_size += map_entry.size;
+  }
+
+  if (lspec_info->data_size == 0) {
+    lspec_info->data_size = data_size;
+  } else if (lspec_info->data_size < data_size) {
+    XG_WARN("specialization data size {} < {}", lspec_info->data_size,
+            data_size);
+    lspec_info->data_size = data_size;
+  }
+}
+
+bool Parser::ResolveLayoutReferences(std::shared_ptr<Layout> layout) {
   assert(layout);
-  const auto& node_id_map = layout->node_id_map;
 
   for (auto lwin : layout->lwindows) {
     lwin->lrenderer = layout->lrenderer;
@@ -662,331 +1257,75 @@ void Parser::ResolveLayoutReferences(std::shared_ptr<Layout> layout) {
     layout->ldevice->lqueues.emplace_back(lqueue);
   }
 
-  for (auto lcmd_pool : layout->lcmd_pools) {
-    if (lcmd_pool->lqueue_id) {
-      const auto it = node_id_map.find(lcmd_pool->lqueue_id);
-      assert(it != node_id_map.end());
-      lcmd_pool->lqueue = std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(lcmd_pool->lqueue);
+  for (auto lcompute_pipeline : layout->lcompute_pipelines) {
+    const auto& lstage = lcompute_pipeline->lstage;
+    if (lstage && lstage->lspec_info) {
+      ResolveSpecializationInfo(lstage->lspec_info.get());
     }
   }
 
-  for (auto lbuffer_loader : layout->lbuffer_loaders) {
-    if (lbuffer_loader->lbuffer_id) {
-      const auto it = node_id_map.find(lbuffer_loader->lbuffer_id);
-      assert(it != node_id_map.end());
-      lbuffer_loader->lbuffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(lbuffer_loader->lbuffer);
-    }
-
-    if (lbuffer_loader->lqueue_id) {
-      const auto it = node_id_map.find(lbuffer_loader->lqueue_id);
-      assert(it != node_id_map.end());
-      lbuffer_loader->lqueue =
-          std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(lbuffer_loader->lqueue);
-    }
-
-    if (lbuffer_loader->ldata_id) {
-      const auto it = node_id_map.find(lbuffer_loader->ldata_id);
-      assert(it != node_id_map.end());
-      auto ldata = std::static_pointer_cast<LayoutData>(it->second);
-      assert(ldata);
-      lbuffer_loader->ldata = ldata;
+  for (auto lgraphics_pipeline : layout->lgraphics_pipelines) {
+    for (auto lstage : lgraphics_pipeline->lstages) {
+      if (lstage->lspec_info) {
+        ResolveSpecializationInfo(lstage->lspec_info.get());
+      }
     }
+    assert(lgraphics_pipeline->lviewport_state);
   }
 
-  for (auto limage : layout->limages) {
-    if (limage->lswapchain_id) {
-      const auto it = node_id_map.find(limage->lswapchain_id);
-      assert(it != node_id_map.end());
-      limage->lswapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(limage->lswapchain);
-    }
+#ifdef XG_ENABLE_REALITY
+  if (layout->lreality) {
+    auto& lreality = layout->lreality;
+    lreality->lsession = layout->lsession;
   }
+#endif  // XG_ENABLE_REALITY
 
-  for (auto limage_loader : layout->limage_loaders) {
-    if (limage_loader->limage_id) {
-      const auto it = node_id_map.find(limage_loader->limage_id);
-      assert(it != node_id_map.end());
-      limage_loader->limage = std::static_pointer_cast<LayoutImage>(it->second);
-      assert(limage_loader->limage);
-    }
+  // the references were recorded as they were parsed
+  if (!ParseContext::GetCurrent()->ResolveReferences()) return false;
 
-    if (limage_loader->lqueue_id) {
-      const auto it = node_id_map.find(limage_loader->lqueue_id);
-      assert(it != node_id_map.end());
-      limage_loader->lqueue = std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(limage_loader->lqueue);
-    }
-  }
-
-  for (auto limage_view : layout->limage_views) {
-    if (limage_view->limage_id) {
-      const auto it = node_id_map.find(limage_view->limage_id);
-      assert(it != node_id_map.end());
-      limage_view->limage = std::static_pointer_cast<LayoutImage>(it->second);
-      assert(limage_view->limage);
-    }
-  }
-
-  for (auto lrender_pass : layout->lrender_passes) {
-    for (auto lattachment : lrender_pass->lattachments) {
-      if (lattachment->lswapchain_id) {
-        const auto it = node_id_map.find(lattachment->lswapchain_id);
-        assert(it != node_id_map.end());
-        lattachment->lswapchain =
-            std::static_pointer_cast<LayoutSwapchain>(it->second);
-        assert(lattachment->lswapchain);
-      }
-    }
-  }
-
-  for (auto lswapchain : layout->lswapchains) {
-    if (lswapchain->lwin_id) {
-      const auto it = node_id_map.find(lswapchain->lwin_id);
-      assert(it != node_id_map.end());
-      lswapchain->lwin = std::static_pointer_cast<LayoutWindow>(it->second);
-      assert(lswapchain->lwin);
-    }
-  }
-
-  for (auto lframe : layout->lframes) {
-    if (lframe->lswapchain_id) {
-      const auto it = node_id_map.find(lframe->lswapchain_id);
-      assert(it != node_id_map.end());
-      lframe->lswapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(lframe->lswapchain);
-    }
-  }
+  // values derived from the resolved references
 
   for (auto lcolor_attachment : layout->lcolor_attachments) {
     assert(lcolor_attachment->lattachment_id);
-    const auto it = node_id_map.find(lcolor_attachment->lattachment_id);
-    assert(it != node_id_map.end());
-    auto lattachment = std::static_pointer_cast<LayoutAttachment>(it->second);
-    assert(lattachment);
-
     const auto& lattachments =
         lcolor_attachment->lsubpass.lock()->lrender_pass.lock()->lattachments;
-    for (auto i = 0; i < lattachments.size(); ++i) {
-      if (lattachments[i] == lattachment) {
-        lcolor_attachment->attachment = i;
-        break;
-      }
-    }
+    lcolor_attachment->attachment =
+        FindIndex(lattachments, lcolor_attachment->lattachment_id);
     assert(lcolor_attachment->attachment != -1);
   }
 
   for (auto ldepth_stencil_attachment : layout->ldepth_stencil_attachments) {
     assert(ldepth_stencil_attachment->lattachment_id);
-    const auto it = node_id_map.find(ldepth_stencil_attachment->lattachment_id);
-    assert(it != node_id_map.end());
-    auto lattachment = std::static_pointer_cast<LayoutAttachment>(it->second);
-    assert(lattachment);
-
     const auto& lattachments = ldepth_stencil_attachment->lsubpass.lock()
                                    ->lrender_pass.lock()
                                    ->lattachments;
-    for (auto i = 0; i < lattachments.size(); ++i) {
-      if (lattachments[i] == lattachment) {
-        ldepth_stencil_attachment->attachment = i;
-        break;
-      }
-    }
+    ldepth_stencil_attachment->attachment =
+        FindIndex(lattachments, ldepth_stencil_attachment->lattachment_id);
     assert(ldepth_stencil_attachment->attachment != -1);
   }
 
   for (auto ldependency : layout->ldependencies) {
+    const auto& lsubpasses = ldependency->lrender_pass.lock()->lsubpasses;
+
     if (ldependency->lsrc_subpass_id) {
-      const auto it = node_id_map.find(ldependency->lsrc_subpass_id);
-      assert(it != node_id_map.end());
-      auto lsrc_subpass = std::static_pointer_cast<LayoutSubpass>(it->second);
-      assert(lsrc_subpass);
-
-      const auto& lsubpasses = ldependency->lrender_pass.lock()->lsubpasses;
-      for (auto i = 0; i < lsubpasses.size(); ++i) {
-        if (lsubpasses[i] == lsrc_subpass) {
-          ldependency->src_subpass = i;
-          break;
-        }
-      }
+      ldependency->src_subpass =
+          FindIndex(lsubpasses, ldependency->lsrc_subpass_id);
       assert(ldependency->src_subpass != -1);
     }
 
     if (ldependency->ldst_subpass_id) {
-      const auto it = node_id_map.find(ldependency->ldst_subpass_id);
-      assert(it != node_id_map.end());
-      auto ldst_subpass = std::static_pointer_cast<LayoutSubpass>(it->second);
-      assert(ldst_subpass);
-
-      const auto& lsubpasses = ldependency->lrender_pass.lock()->lsubpasses;
-      for (auto i = 0; i < lsubpasses.size(); ++i) {
-        if (lsubpasses[i] == ldst_subpass) {
-          ldependency->dst_subpass = i;
-          break;
-        }
-      }
+      ldependency->dst_subpass =
+          FindIndex(lsubpasses, ldependency->ldst_subpass_id);
       assert(ldependency->dst_subpass != -1);
     }
   }
 
-  for (auto lpipeline_layout : layout->lpipeline_layouts) {
-    for (auto ldesc_set_layout_id : lpipeline_layout->ldesc_set_layout_ids) {
-      const auto it = node_id_map.find(ldesc_set_layout_id);
-      assert(it != node_id_map.end());
-      auto ldesc_set_layout =
-          std::static_pointer_cast<LayoutDescriptorSetLayout>(it->second);
-      assert(ldesc_set_layout);
-
-      lpipeline_layout->ldesc_set_layouts.emplace_back(ldesc_set_layout);
-    }
-    lpipeline_layout->ldesc_set_layout_ids.clear();
-  }
-
-  for (auto lcompute_pipeline : layout->lcompute_pipelines) {
-    if (lcompute_pipeline->lstage) {
-      auto lstage = lcompute_pipeline->lstage;
-      if (lstage->lshader_module_id) {
-        const auto it = node_id_map.find(lstage->lshader_module_id);
-        assert(it != node_id_map.end());
-        auto lshader_module =
-            std::static_pointer_cast<LayoutShaderModule>(it->second);
-        assert(lshader_module);
-
-        lstage->lshader_module = lshader_module;
-      }
-
-      if (lstage->lspec_info) {
-        auto lspec_info = lstage->lspec_info;
-        size_t data_size = 0;
-        for (const auto& map_entry : lspec_info->map_entries) {
-          data_size += map_entry.size;
-        }
-
-        if (lspec_info->data_size == 0) {
-          lspec_info->data_size = data_size;
-        } else if (lspec_info->data_size < data_size) {
-          XG_WARN("specialization data size {} < {}", lspec_info->data_size,
-                  data_size);
-          lspec_info->data_size = data_size;
-        }
-
-        if (lspec_info->ldata_id) {
-          const auto it = node_id_map.find(lspec_info->ldata_id);
-          assert(it != node_id_map.end());
-          lspec_info->ldata = std::static_pointer_cast<LayoutData>(it->second);
-          assert(lspec_info->ldata);
-        }
-      }
-    }
-
-    if (lcompute_pipeline->llayout_id) {
-      const auto it = node_id_map.find(lcompute_pipeline->llayout_id);
-      assert(it != node_id_map.end());
-      lcompute_pipeline->llayout =
-          std::static_pointer_cast<LayoutPipelineLayout>(it->second);
-      assert(lcompute_pipeline->llayout);
-    }
-  }
-
   for (auto lgraphics_pipeline : layout->lgraphics_pipelines) {
-    for (auto lstage : lgraphics_pipeline->lstages) {
-      if (lstage->lshader_module_id) {
-        const auto it = node_id_map.find(lstage->lshader_module_id);
-        assert(it != node_id_map.end());
-        auto lshader_module =
-            std::static_pointer_cast<LayoutShaderModule>(it->second);
-        assert(lshader_module);
-
-        lstage->lshader_module = lshader_module;
-      }
-
-      if (lstage->lspec_info) {
-        auto lspec_info = lstage->lspec_info;
-        size_t data_size = 0;
-        for (const auto& map_entry : lspec_info->map_entries) {
-          data_size += map_entry.size;
-        }
-
-        if (lspec_info->data_size == 0) {
-          lspec_info->data_size = data_size;
-        } else if (lspec_info->data_size < data_size) {
-          XG_WARN("specialization data size {} < {}", lspec_info->data_size,
-                  data_size);
-          lspec_info->data_size = data_size;
-        }
-
-        if (lspec_info->ldata_id) {
-          const auto it = node_id_map.find(lspec_info->ldata_id);
-          assert(it != node_id_map.end());
-          lspec_info->ldata = std::static_pointer_cast<LayoutData>(it->second);
-          assert(lspec_info->ldata);
-        }
-      }
-    }
-
-    if (lgraphics_pipeline->llayout_id) {
-      const auto it = node_id_map.find(lgraphics_pipeline->llayout_id);
-      assert(it != node_id_map.end());
-      lgraphics_pipeline->llayout =
-          std::static_pointer_cast<LayoutPipelineLayout>(it->second);
-      assert(lgraphics_pipeline->llayout);
-    }
-
-    if (lgraphics_pipeline->lrender_pass_id) {
-      const auto it = node_id_map.find(lgraphics_pipeline->lrender_pass_id);
-      assert(it != node_id_map.end());
-      lgraphics_pipeline->lrender_pass =
-          std::static_pointer_cast<LayoutRenderPass>(it->second);
-      assert(lgraphics_pipeline->lrender_pass);
-    }
-
     assert(lgraphics_pipeline->lsubpass_id);
-    const auto it = node_id_map.find(lgraphics_pipeline->lsubpass_id);
-    assert(it != node_id_map.end());
-    auto lsubpass = std::static_pointer_cast<LayoutSubpass>(it->second);
-    assert(lsubpass);
-
-    const auto& lsubpasses = lgraphics_pipeline->lrender_pass->lsubpasses;
-    for (auto i = 0; i < lsubpasses.size(); ++i) {
-      if (lsubpasses[i] == lsubpass) {
-        lgraphics_pipeline->subpass = i;
-        break;
-      }
-    }
+    lgraphics_pipeline->subpass =
+        FindIndex(lgraphics_pipeline->lrender_pass->lsubpasses,
+                  lgraphics_pipeline->lsubpass_id);
     assert(lgraphics_pipeline->subpass != -1);
-
-    auto lviewport_state = lgraphics_pipeline->lviewport_state;
-    assert(lviewport_state);
-    if (lviewport_state->lswapchain_id) {
-      const auto it = node_id_map.find(lviewport_state->lswapchain_id);
-      assert(it != node_id_map.end());
-      lviewport_state->lswapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(lviewport_state->lswapchain);
-    }
-  }
-
-  for (auto ldesc_set : layout->ldesc_sets) {
-    if (ldesc_set->ldesc_pool_id) {
-      const auto it = node_id_map.find(ldesc_set->ldesc_pool_id);
-      assert(it != node_id_map.end());
-      ldesc_set->ldesc_pool =
-          std::static_pointer_cast<LayoutDescriptorPool>(it->second);
-      assert(ldesc_set->ldesc_pool);
-    }
-
-    if (ldesc_set->lset_layout_id) {
-      const auto it = node_id_map.find(ldesc_set->lset_layout_id);
-      assert(it != node_id_map.end());
-      ldesc_set->lset_layout =
-          std::static_pointer_cast<LayoutDescriptorSetLayout>(it->second);
-      assert(ldesc_set->lset_layout);
-    }
   }
 
   for (auto ldesc : layout->ldescriptors) {
@@ -1018,207 +1357,7 @@ void Parser::ResolveLayoutReferences(std::shared_ptr<Layout> layout) {
     }
   }
 
-  for (auto ldesc_image_info : layout->ldesc_image_infos) {
-    if (ldesc_image_info->lsampler_id) {
-      const auto it = node_id_map.find(ldesc_image_info->lsampler_id);
-      assert(it != node_id_map.end());
-      ldesc_image_info->lsampler =
-          std::static_pointer_cast<LayoutSampler>(it->second);
-      assert(ldesc_image_info->lsampler);
-    }
-
-    if (ldesc_image_info->limage_view_id) {
-      const auto it = node_id_map.find(ldesc_image_info->limage_view_id);
-      assert(it != node_id_map.end());
-      ldesc_image_info->limage_view =
-          std::static_pointer_cast<LayoutImageView>(it->second);
-      assert(ldesc_image_info->limage_view);
-    }
-  }
-
-  for (auto ldesc_buffer_info : layout->ldesc_buffer_infos) {
-    if (ldesc_buffer_info->lbuffer_id) {
-      const auto it = node_id_map.find(ldesc_buffer_info->lbuffer_id);
-      assert(it != node_id_map.end());
-      ldesc_buffer_info->lbuffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(ldesc_buffer_info->lbuffer);
-    }
-  }
-
-  for (auto lcmd_buffer : layout->lcmd_buffers) {
-    if (lcmd_buffer->lcmd_pool_id) {
-      const auto it = node_id_map.find(lcmd_buffer->lcmd_pool_id);
-      assert(it != node_id_map.end());
-      lcmd_buffer->lcmd_pool =
-          std::static_pointer_cast<LayoutCommandPool>(it->second);
-      assert(lcmd_buffer->lcmd_pool);
-    }
-  }
-
-  for (auto lframebuffer : layout->lframebuffers) {
-    if (lframebuffer->lrender_pass_id) {
-      const auto it = node_id_map.find(lframebuffer->lrender_pass_id);
-      assert(it != node_id_map.end());
-      lframebuffer->lrender_pass =
-          std::static_pointer_cast<LayoutRenderPass>(it->second);
-      assert(lframebuffer->lrender_pass);
-
-      if (lframebuffer->lswapchain_id) {
-        const auto it = node_id_map.find(lframebuffer->lswapchain_id);
-        assert(it != node_id_map.end());
-        lframebuffer->lswapchain =
-            std::static_pointer_cast<LayoutSwapchain>(it->second);
-        assert(lframebuffer->lswapchain);
-      }
-    }
-
-    for (auto& lattachment : lframebuffer->lattachments) {
-      if (lattachment.limage_view_id) {
-        const auto it = node_id_map.find(lattachment.limage_view_id);
-        assert(it != node_id_map.end());
-        lattachment.limage_view =
-            std::static_pointer_cast<LayoutImageView>(it->second);
-        assert(lattachment.limage_view);
-      } else if (lattachment.lswapchain_id) {
-        const auto it = node_id_map.find(lattachment.lswapchain_id);
-        assert(it != node_id_map.end());
-        lattachment.lswapchain =
-            std::static_pointer_cast<LayoutSwapchain>(it->second);
-        assert(lattachment.lswapchain);
-      }
-    }
-  }
-
-  for (auto lcamera : layout->lcameras) {
-    if (lcamera->lswapchain_id) {
-      const auto it = node_id_map.find(lcamera->lswapchain_id);
-      assert(it != node_id_map.end());
-      lcamera->lswapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(lcamera->lswapchain);
-    }
-  }
-
-  for (auto lcmd_group : layout->lcmd_groups) {
-    int i = 0;
-    for (auto& lcmd_node_id : lcmd_group->lcmd_node_ids) {
-      if (lcmd_node_id) {
-        const auto it = node_id_map.find(lcmd_node_id);
-        assert(it != node_id_map.end());
-        lcmd_group->lcmd_nodes[i] =
-            std::static_pointer_cast<LayoutBase>(it->second);
-        assert(lcmd_group->lcmd_nodes[i]);
-      }
-      ++i;
-    }
-    lcmd_group->lcmd_node_ids.clear();
-  }
-
-  for (auto lcmd_context : layout->lcmd_contexts) {
-    if (lcmd_context->lcmd_group_id) {
-      const auto it = node_id_map.find(lcmd_context->lcmd_group_id);
-      assert(it != node_id_map.end());
-      lcmd_context->lcmd_group =
-          std::static_pointer_cast<LayoutCommandGroup>(it->second);
-      assert(lcmd_context->lcmd_group);
-    }
-
-    if (lcmd_context->lcmd_buffer_id) {
-      const auto it = node_id_map.find(lcmd_context->lcmd_buffer_id);
-      assert(it != node_id_map.end());
-      lcmd_context->lcmd_buffer =
-          std::static_pointer_cast<LayoutCommandBuffer>(it->second);
-      assert(lcmd_context->lcmd_buffer);
-    }
-  }
-
-  for (auto lfunction : layout->lfunctions) {
-    if (lfunction->ldata_id) {
-      const auto it = node_id_map.find(lfunction->ldata_id);
-      assert(it != node_id_map.end());
-      lfunction->ldata = std::static_pointer_cast<LayoutData>(it->second);
-      assert(lfunction->ldata);
-    }
-  }
-
-  for (auto lbuffer_memory_barrier : layout->lbuffer_memory_barriers) {
-    if (lbuffer_memory_barrier->lbuffer_id) {
-      const auto it = node_id_map.find(lbuffer_memory_barrier->lbuffer_id);
-      assert(it != node_id_map.end());
-      lbuffer_memory_barrier->lbuffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(lbuffer_memory_barrier->lbuffer);
-    }
-
-    if (lbuffer_memory_barrier->lsrc_queue_id) {
-      const auto it = node_id_map.find(lbuffer_memory_barrier->lsrc_queue_id);
-      assert(it != node_id_map.end());
-      lbuffer_memory_barrier->lsrc_queue =
-          std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(lbuffer_memory_barrier->lsrc_queue);
-    }
-
-    if (lbuffer_memory_barrier->ldst_queue_id) {
-      const auto it = node_id_map.find(lbuffer_memory_barrier->ldst_queue_id);
-      assert(it != node_id_map.end());
-      lbuffer_memory_barrier->ldst_queue =
-          std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(lbuffer_memory_barrier->ldst_queue);
-    }
-  }
-
-  for (auto limage_memory_barrier : layout->limage_memory_barriers) {
-    if (limage_memory_barrier->limage_id) {
-      const auto it = node_id_map.find(limage_memory_barrier->limage_id);
-      assert(it != node_id_map.end());
-      limage_memory_barrier->limage =
-          std::static_pointer_cast<LayoutImage>(it->second);
-      assert(limage_memory_barrier->limage);
-    }
-
-    if (limage_memory_barrier->lswapchain_id) {
-      const auto it = node_id_map.find(limage_memory_barrier->lswapchain_id);
-      assert(it != node_id_map.end());
-      limage_memory_barrier->lswapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(limage_memory_barrier->lswapchain);
-    }
-
-    if (limage_memory_barrier->lsrc_queue_id) {
-      const auto it = node_id_map.find(limage_memory_barrier->lsrc_queue_id);
-      assert(it != node_id_map.end());
-      limage_memory_barrier->lsrc_queue =
-          std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(limage_memory_barrier->lsrc_queue);
-    }
-
-    if (limage_memory_barrier->ldst_queue_id) {
-      const auto it = node_id_map.find(limage_memory_barrier->ldst_queue_id);
-      assert(it != node_id_map.end());
-      limage_memory_barrier->ldst_queue =
-          std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(limage_memory_barrier->ldst_queue);
-    }
-  }
-
   for (auto lcopy_buffer : layout->lcopy_buffers) {
-    if (lcopy_buffer->lsrc_buffer_id) {
-      const auto it = node_id_map.find(lcopy_buffer->lsrc_buffer_id);
-      assert(it != node_id_map.end());
-      lcopy_buffer->lsrc_buffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(lcopy_buffer->lsrc_buffer);
-    }
-
-    if (lcopy_buffer->ldst_buffer_id) {
-      const auto it = node_id_map.find(lcopy_buffer->ldst_buffer_id);
-      assert(it != node_id_map.end());
-      lcopy_buffer->ldst_buffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(lcopy_buffer->ldst_buffer);
-    }
-
     if (lcopy_buffer->regions.size() == 0) {
       BufferCopy region = {};
       region.size = std::min(lcopy_buffer->lsrc_buffer->size,
@@ -1227,573 +1366,7 @@ void Parser::ResolveLayoutReferences(std::shared_ptr<Layout> layout) {
     }
   }
 
-  for (auto lbegin_render_pass : layout->lbegin_render_passes) {
-    if (lbegin_render_pass->lrender_pass_id) {
-      const auto it = node_id_map.find(lbegin_render_pass->lrender_pass_id);
-      assert(it != node_id_map.end());
-      lbegin_render_pass->lrender_pass =
-          std::static_pointer_cast<LayoutRenderPass>(it->second);
-      assert(lbegin_render_pass->lrender_pass);
-    }
-
-    if (lbegin_render_pass->lframebuffer_id) {
-      const auto it = node_id_map.find(lbegin_render_pass->lframebuffer_id);
-      assert(it != node_id_map.end());
-      lbegin_render_pass->lframebuffer =
-          std::static_pointer_cast<LayoutFramebuffer>(it->second);
-      assert(lbegin_render_pass->lframebuffer);
-    }
-  }
-
-  for (auto lbind_desc_sets : layout->lbind_desc_sets) {
-    if (lbind_desc_sets->llayout_id) {
-      const auto it = node_id_map.find(lbind_desc_sets->llayout_id);
-      assert(it != node_id_map.end());
-      lbind_desc_sets->layout =
-          std::static_pointer_cast<LayoutPipelineLayout>(it->second);
-      assert(lbind_desc_sets->layout);
-    }
-
-    for (auto& ldesc_set_id : lbind_desc_sets->ldesc_set_ids) {
-      const auto it = node_id_map.find(ldesc_set_id);
-      assert(it != node_id_map.end());
-      auto ldesc_set =
-          std::static_pointer_cast<LayoutDescriptorSet>(it->second);
-      assert(ldesc_set);
-      lbind_desc_sets->ldesc_sets.emplace_back(ldesc_set);
-    }
-    lbind_desc_sets->ldesc_set_ids.clear();
-
-    for (auto& ldynamic_offset : lbind_desc_sets->ldynamic_offsets) {
-      const auto it = node_id_map.find(ldynamic_offset.lbuffer_id);
-      assert(it != node_id_map.end());
-      ldynamic_offset.lbuffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(ldynamic_offset.lbuffer);
-    }
-  }
-
-  for (auto lbind_pipeline : layout->lbind_pipelines) {
-    if (lbind_pipeline->lpipeline_id) {
-      const auto it = node_id_map.find(lbind_pipeline->lpipeline_id);
-      assert(it != node_id_map.end());
-      lbind_pipeline->lpipeline =
-          std::static_pointer_cast<LayoutBase>(it->second);
-      assert(lbind_pipeline->lpipeline);
-    }
-  }
-
-  for (auto lbind_vertex_buffers : layout->lbind_vertex_buffers) {
-    for (auto& lbuffer_id : lbind_vertex_buffers->lbuffer_ids) {
-      const auto it = node_id_map.find(lbuffer_id);
-      assert(it != node_id_map.end());
-      auto lbuffer = std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(lbuffer);
-      lbind_vertex_buffers->lbuffers.emplace_back(lbuffer);
-    }
-    lbind_vertex_buffers->lbuffer_ids.clear();
-  }
-
-  for (auto lbind_index_buffer : layout->lbind_index_buffers) {
-    if (lbind_index_buffer->lbuffer_id) {
-      const auto it = node_id_map.find(lbind_index_buffer->lbuffer_id);
-      assert(it != node_id_map.end());
-      lbind_index_buffer->lbuffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(lbind_index_buffer->lbuffer);
-    }
-  }
-
-  for (auto ldraw_indexed_indirect : layout->ldraw_indexed_indirects) {
-    if (ldraw_indexed_indirect->lbuffer_id) {
-      const auto it = node_id_map.find(ldraw_indexed_indirect->lbuffer_id);
-      assert(it != node_id_map.end());
-      ldraw_indexed_indirect->lbuffer =
-          std::static_pointer_cast<LayoutBuffer>(it->second);
-      assert(ldraw_indexed_indirect->lbuffer);
-    }
-  }
-
-  for (auto lblit_image : layout->lblit_images) {
-    if (lblit_image->lsrc_image_id) {
-      const auto it = node_id_map.find(lblit_image->lsrc_image_id);
-      assert(it != node_id_map.end());
-      lblit_image->lsrc_image =
-          std::static_pointer_cast<LayoutImage>(it->second);
-      assert(lblit_image->lsrc_image);
-    }
-
-    if (lblit_image->lsrc_swapchain_id) {
-      const auto it = node_id_map.find(lblit_image->lsrc_swapchain_id);
-      assert(it != node_id_map.end());
-      lblit_image->lsrc_swapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(lblit_image->lsrc_swapchain);
-    }
-
-    if (lblit_image->ldst_image_id) {
-      const auto it = node_id_map.find(lblit_image->ldst_image_id);
-      assert(it != node_id_map.end());
-      lblit_image->ldst_image =
-          std::static_pointer_cast<LayoutImage>(it->second);
-      assert(lblit_image->ldst_image);
-    }
-
-    if (lblit_image->ldst_swapchain_id) {
-      const auto it = node_id_map.find(lblit_image->ldst_swapchain_id);
-      assert(it != node_id_map.end());
-      lblit_image->ldst_swapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(lblit_image->ldst_swapchain);
-    }
-  }
-
-  for (auto lpush_constants : layout->lpush_constants) {
-    if (lpush_constants->llayout_id) {
-      const auto it = node_id_map.find(lpush_constants->llayout_id);
-      assert(it != node_id_map.end());
-      lpush_constants->llayout =
-          std::static_pointer_cast<LayoutPipelineLayout>(it->second);
-      assert(lpush_constants->llayout);
-    }
-
-    if (lpush_constants->ldata_id) {
-      const auto it = node_id_map.find(lpush_constants->ldata_id);
-      assert(it != node_id_map.end());
-      lpush_constants->ldata = std::static_pointer_cast<LayoutData>(it->second);
-      assert(lpush_constants->ldata);
-    }
-  }
-
-  for (auto lreset_query_pool : layout->lreset_query_pools) {
-    if (lreset_query_pool->lquery_pool_id) {
-      const auto it = node_id_map.find(lreset_query_pool->lquery_pool_id);
-      assert(it != node_id_map.end());
-      lreset_query_pool->lquery_pool =
-          std::static_pointer_cast<LayoutQueryPool>(it->second);
-      assert(lreset_query_pool->lquery_pool);
-    }
-  }
-
-  for (auto lset_event : layout->lset_events) {
-    if (lset_event->levent_id) {
-      const auto it = node_id_map.find(lset_event->levent_id);
-      assert(it != node_id_map.end());
-      lset_event->levent = std::static_pointer_cast<LayoutEvent>(it->second);
-      assert(lset_event->levent);
-    }
-  }
-
-  for (auto lreset_event : layout->lreset_events) {
-    if (lreset_event->levent_id) {
-      const auto it = node_id_map.find(lreset_event->levent_id);
-      assert(it != node_id_map.end());
-      lreset_event->levent = std::static_pointer_cast<LayoutEvent>(it->second);
-      assert(lreset_event->levent);
-    }
-  }
-
-  for (auto ldraw_overlay : layout->ldraw_overlays) {
-    if (ldraw_overlay->loverlay_id) {
-      const auto it = node_id_map.find(ldraw_overlay->loverlay_id);
-      assert(it != node_id_map.end());
-      ldraw_overlay->loverlay =
-          std::static_pointer_cast<LayoutOverlay>(it->second);
-      assert(ldraw_overlay->loverlay);
-    }
-  }
-
-  for (auto loverlay : layout->loverlays) {
-    if (loverlay->lwin_id) {
-      const auto it = node_id_map.find(loverlay->lwin_id);
-      assert(it != node_id_map.end());
-      loverlay->lwin = std::static_pointer_cast<LayoutWindow>(it->second);
-      assert(loverlay->lwin);
-    }
-
-    if (loverlay->lqueue_id) {
-      const auto it = node_id_map.find(loverlay->lqueue_id);
-      assert(it != node_id_map.end());
-      loverlay->lqueue = std::static_pointer_cast<LayoutQueue>(it->second);
-      assert(loverlay->lqueue);
-    }
-
-    if (loverlay->ldesc_pool_id) {
-      const auto it = node_id_map.find(loverlay->ldesc_pool_id);
-      assert(it != node_id_map.end());
-      loverlay->ldesc_pool =
-          std::static_pointer_cast<LayoutDescriptorPool>(it->second);
-      assert(loverlay->ldesc_pool);
-    }
-
-    if (loverlay->lswapchain_id) {
-      const auto it = node_id_map.find(loverlay->lswapchain_id);
-      assert(it != node_id_map.end());
-      loverlay->lswapchain =
-          std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(loverlay->lswapchain);
-    }
-
-    if (loverlay->lrender_pass_id) {
-      const auto it = node_id_map.find(loverlay->lrender_pass_id);
-      assert(it != node_id_map.end());
-      loverlay->lrender_pass =
-          std::static_pointer_cast<LayoutRenderPass>(it->second);
-      assert(loverlay->lrender_pass);
-    }
-  }
-
-  for (auto lwin_viewer : layout->lwindow_viewers) {
-    if (lwin_viewer->lwin_id) {
-      const auto it = node_id_map.find(lwin_viewer->lwin_id);
-      assert(it != node_id_map.end());
-      lwin_viewer->lwin = std::static_pointer_cast<LayoutWindow>(it->second);
-      assert(lwin_viewer->lwin);
-    }
-
-    if (lwin_viewer->lframe_id) {
-      const auto it = node_id_map.find(lwin_viewer->lframe_id);
-      assert(it != node_id_map.end());
-      lwin_viewer->lframe = std::static_pointer_cast<LayoutFrame>(it->second);
-      assert(lwin_viewer->lframe);
-    }
-
-    if (lwin_viewer->lcamera_id) {
-      const auto it = node_id_map.find(lwin_viewer->lcamera_id);
-      assert(it != node_id_map.end());
-      lwin_viewer->lcamera = std::static_pointer_cast<LayoutCamera>(it->second);
-      assert(lwin_viewer->lcamera);
-    }
-
-    if (lwin_viewer->loverlay_id) {
-      const auto it = node_id_map.find(lwin_viewer->loverlay_id);
-      assert(it != node_id_map.end());
-      lwin_viewer->loverlay =
-          std::static_pointer_cast<LayoutOverlay>(it->second);
-      assert(lwin_viewer->loverlay);
-    }
-
-    for (auto& lcmd_context_id : lwin_viewer->lcmd_context_ids) {
-      const auto it = node_id_map.find(lcmd_context_id);
-      assert(it != node_id_map.end());
-      auto lcmd_context =
-          std::static_pointer_cast<LayoutCommandContext>(it->second);
-      assert(lcmd_context);
-      lwin_viewer->lcmd_contexts.emplace_back(lcmd_context);
-    }
-    lwin_viewer->lcmd_context_ids.clear();
-
-    if (lwin_viewer->lacquire_next_image) {
-      auto& lacquire_next_image = lwin_viewer->lacquire_next_image;
-      if (lacquire_next_image->lwait_fence_id) {
-        const auto it = node_id_map.find(lacquire_next_image->lwait_fence_id);
-        assert(it != node_id_map.end());
-        lacquire_next_image->lwait_fence =
-            std::static_pointer_cast<LayoutFence>(it->second);
-        assert(lacquire_next_image->lwait_fence);
-      }
-
-      if (lacquire_next_image->lsemaphore_id) {
-        const auto it = node_id_map.find(lacquire_next_image->lsemaphore_id);
-        assert(it != node_id_map.end());
-        lacquire_next_image->lsemaphore =
-            std::static_pointer_cast<LayoutSemaphore>(it->second);
-        assert(lacquire_next_image->lsemaphore);
-      }
-
-      if (lacquire_next_image->lfence_id) {
-        const auto it = node_id_map.find(lacquire_next_image->lfence_id);
-        assert(it != node_id_map.end());
-        lacquire_next_image->lfence =
-            std::static_pointer_cast<LayoutFence>(it->second);
-        assert(lacquire_next_image->lfence);
-      }
-    }
-
-    for (auto& lqueue_submit_id : lwin_viewer->lqueue_submit_ids) {
-      const auto it = node_id_map.find(lqueue_submit_id);
-      assert(it != node_id_map.end());
-      auto lqueue_submit =
-          std::static_pointer_cast<LayoutQueueSubmit>(it->second);
-      assert(lqueue_submit);
-      lwin_viewer->lqueue_submits.emplace_back(lqueue_submit);
-    }
-    lwin_viewer->lqueue_submit_ids.clear();
-
-    if (lwin_viewer->lresizer) {
-      auto lresizer = lwin_viewer->lresizer;
-
-      for (auto& limage_id : lresizer->limage_ids) {
-        const auto it = node_id_map.find(limage_id);
-        assert(it != node_id_map.end());
-        auto limage = std::static_pointer_cast<LayoutImage>(it->second);
-        assert(limage);
-        lresizer->limages.emplace_back(limage);
-      }
-      lresizer->limage_ids.clear();
-
-      for (auto& limage_view_id : lresizer->limage_view_ids) {
-        const auto it = node_id_map.find(limage_view_id);
-        assert(it != node_id_map.end());
-        auto limage_view =
-            std::static_pointer_cast<LayoutImageView>(it->second);
-        assert(limage_view);
-        lresizer->limage_views.emplace_back(limage_view);
-      }
-      lresizer->limage_view_ids.clear();
-
-      for (auto& lgraphics_pipeline_id : lresizer->lgraphics_pipeline_ids) {
-        const auto it = node_id_map.find(lgraphics_pipeline_id);
-        assert(it != node_id_map.end());
-        auto lgraphics_pipeline =
-            std::static_pointer_cast<LayoutGraphicsPipeline>(it->second);
-        assert(lgraphics_pipeline);
-        lresizer->lgraphics_pipelines.emplace_back(lgraphics_pipeline);
-      }
-      lresizer->lgraphics_pipeline_ids.clear();
-
-      for (auto& lframebuffer_id : lresizer->lframebuffer_ids) {
-        const auto it = node_id_map.find(lframebuffer_id);
-        assert(it != node_id_map.end());
-        auto lframebuffer =
-            std::static_pointer_cast<LayoutFramebuffer>(it->second);
-        assert(lframebuffer);
-        lresizer->lframebuffers.emplace_back(lframebuffer);
-      }
-      lresizer->lframebuffer_ids.clear();
-    }
-
-    if (lwin_viewer->lupdater) {
-      auto lupdater = lwin_viewer->lupdater;
-      for (auto& lbuffer_id : lupdater->lbuffer_ids) {
-        const auto it = node_id_map.find(lbuffer_id);
-        assert(it != node_id_map.end());
-        auto lbuffer = std::static_pointer_cast<LayoutBuffer>(it->second);
-        assert(lbuffer);
-        lupdater->lbuffers.emplace_back(lbuffer);
-      }
-      lupdater->lbuffer_ids.clear();
-    }
-  }
-
-  for (auto& lqueue_submit : layout->lqueue_submits) {
-    const auto it = node_id_map.find(lqueue_submit->lqueue_id);
-    assert(it != node_id_map.end());
-    lqueue_submit->lqueue = std::static_pointer_cast<LayoutQueue>(it->second);
-    assert(lqueue_submit->lqueue);
-
-    for (auto& lsubmit : lqueue_submit->lsubmits) {
-      for (auto& lwait_semaphore_id : lsubmit->lwait_semaphore_ids) {
-        const auto it = node_id_map.find(lwait_semaphore_id);
-        assert(it != node_id_map.end());
-        auto lwait_semaphore =
-            std::static_pointer_cast<LayoutSemaphore>(it->second);
-        assert(lwait_semaphore);
-        lsubmit->lwait_semaphores.emplace_back(lwait_semaphore);
-      }
-      lsubmit->lwait_semaphore_ids.clear();
-
-      for (auto& lcmd_buffer_id : lsubmit->lcmd_buffer_ids) {
-        const auto it = node_id_map.find(lcmd_buffer_id);
-        assert(it != node_id_map.end());
-        auto lcmd_buffer =
-            std::static_pointer_cast<LayoutCommandBuffer>(it->second);
-        assert(lcmd_buffer);
-        lsubmit->lcmd_buffers.emplace_back(lcmd_buffer);
-      }
-      lsubmit->lcmd_buffer_ids.clear();
-
-      for (auto& lsignal_semaphore_id : lsubmit->lsignal_semaphore_ids) {
-        const auto it = node_id_map.find(lsignal_semaphore_id);
-        assert(it != node_id_map.end());
-        auto lsignal_semaphore =
-            std::static_pointer_cast<LayoutSemaphore>(it->second);
-        assert(lsignal_semaphore);
-        lsubmit->lsignal_semaphores.emplace_back(lsignal_semaphore);
-      }
-      lsubmit->lsignal_semaphore_ids.clear();
-    }
-
-    if (lqueue_submit->lfence_id) {
-      const auto it = node_id_map.find(lqueue_submit->lfence_id);
-      assert(it != node_id_map.end());
-      lqueue_submit->lfence = std::static_pointer_cast<LayoutFence>(it->second);
-      assert(lqueue_submit->lfence);
-    }
-  }
-
-  for (auto& lqueue_present : layout->lqueue_presents) {
-    const auto it = node_id_map.find(lqueue_present->lqueue_id);
-    assert(it != node_id_map.end());
-    lqueue_present->lqueue = std::static_pointer_cast<LayoutQueue>(it->second);
-    assert(lqueue_present->lqueue);
-
-    for (auto& lwait_semaphore_id : lqueue_present->lwait_semaphore_ids) {
-      const auto it = node_id_map.find(lwait_semaphore_id);
-      assert(it != node_id_map.end());
-      auto lwait_semaphore =
-          std::static_pointer_cast<LayoutSemaphore>(it->second);
-      assert(lwait_semaphore);
-      lqueue_present->lwait_semaphores.emplace_back(lwait_semaphore);
-    }
-    lqueue_present->lwait_semaphore_ids.clear();
-
-    for (auto& lswapchain_id : lqueue_present->lswapchain_ids) {
-      const auto it = node_id_map.find(lswapchain_id);
-      assert(it != node_id_map.end());
-      auto lswapchain = std::static_pointer_cast<LayoutSwapchain>(it->second);
-      assert(lswapchain);
-      lqueue_present->lswapchains.emplace_back(lswapchain);
-    }
-    lqueue_present->lswapchain_ids.clear();
-  }
-
-#ifdef XG_ENABLE_REALITY
-  if (layout->lreality) {
-    auto& lreality = layout->lreality;
-    lreality->lsession = layout->lsession;
-  }
-
-  if (layout->lsession) {
-    auto& lsession = layout->lsession;
-    const auto it = node_id_map.find(lsession->lqueue_id);
-    assert(it != node_id_map.end());
-    lsession->lqueue = std::static_pointer_cast<LayoutQueue>(it->second);
-    assert(lsession->lqueue);
-  }
-
-  for (auto lcomposition_layer_projection :
-       layout->lcomposition_layer_projections) {
-    if (lcomposition_layer_projection->lspace_id) {
-      const auto it =
-          node_id_map.find(lcomposition_layer_projection->lspace_id);
-      assert(it != node_id_map.end());
-      lcomposition_layer_projection->lspace =
-          std::static_pointer_cast<LayoutBase>(it->second);
-      assert(lcomposition_layer_projection->lspace);
-    }
-
-    for (auto& lview : lcomposition_layer_projection->lviews) {
-      if (lview.lswapchain_id) {
-        const auto it = node_id_map.find(lview.lswapchain_id);
-        assert(it != node_id_map.end());
-        lview.lswapchain =
-            std::static_pointer_cast<LayoutSwapchain>(it->second);
-        assert(lview.lswapchain);
-      }
-    }
-  }
-
-  for (auto lreality_viewer : layout->lreality_viewers) {
-    if (lreality_viewer->lspace_id) {
-      const auto it = node_id_map.find(lreality_viewer->lspace_id);
-      assert(it != node_id_map.end());
-      lreality_viewer->lspace =
-          std::static_pointer_cast<LayoutBase>(it->second);
-      assert(lreality_viewer->lspace);
-    }
-
-    for (auto lview : lreality_viewer->lviews) {
-      if (lview->lframe_id) {
-        const auto it = node_id_map.find(lview->lframe_id);
-        assert(it != node_id_map.end());
-        lview->lframe = std::static_pointer_cast<LayoutFrame>(it->second);
-        assert(lview->lframe);
-      }
-
-      if (lview->lcamera_id) {
-        const auto it = node_id_map.find(lview->lcamera_id);
-        assert(it != node_id_map.end());
-        lview->lcamera = std::static_pointer_cast<LayoutCamera>(it->second);
-        assert(lview->lcamera);
-      }
-
-      for (auto& lcmd_context_id : lview->lcmd_context_ids) {
-        const auto it = node_id_map.find(lcmd_context_id);
-        assert(it != node_id_map.end());
-        auto lcmd_context =
-            std::static_pointer_cast<LayoutCommandContext>(it->second);
-        assert(lcmd_context);
-        lview->lcmd_contexts.emplace_back(lcmd_context);
-      }
-      lview->lcmd_context_ids.clear();
-
-      if (lview->lacquire_next_image) {
-        auto& lacquire_next_image = lview->lacquire_next_image;
-        if (lacquire_next_image->lwait_fence_id) {
-          const auto it = node_id_map.find(lacquire_next_image->lwait_fence_id);
-          assert(it != node_id_map.end());
-          lacquire_next_image->lwait_fence =
-              std::static_pointer_cast<LayoutFence>(it->second);
-          assert(lacquire_next_image->lwait_fence);
-        }
-
-        if (lacquire_next_image->lsemaphore_id) {
-          const auto it = node_id_map.find(lacquire_next_image->lsemaphore_id);
-          assert(it != node_id_map.end());
-          lacquire_next_image->lsemaphore =
-              std::static_pointer_cast<LayoutSemaphore>(it->second);
-          assert(lacquire_next_image->lsemaphore);
-        }
-
-        if (lacquire_next_image->lfence_id) {
-          const auto it = node_id_map.find(lacquire_next_image->lfence_id);
-          assert(it != node_id_map.end());
-          lacquire_next_image->lfence =
-              std::static_pointer_cast<LayoutFence>(it->second);
-          assert(lacquire_next_image->lfence);
-        }
-      }
-
-      for (auto& lqueue_submit_id : lview->lqueue_submit_ids) {
-        const auto it = node_id_map.find(lqueue_submit_id);
-        assert(it != node_id_map.end());
-        auto lqueue_submit =
-            std::static_pointer_cast<LayoutQueueSubmit>(it->second);
-        assert(lqueue_submit);
-        lview->lqueue_submits.emplace_back(lqueue_submit);
-      }
-      lview->lqueue_submit_ids.clear();
-
-      if (lview->lupdater) {
-        auto lupdater = lview->lupdater;
-        for (auto& lbuffer_id : lupdater->lbuffer_ids) {
-          const auto it = node_id_map.find(lbuffer_id);
-          assert(it != node_id_map.end());
-          auto lbuffer = std::static_pointer_cast<LayoutBuffer>(it->second);
-          assert(lbuffer);
-          lupdater->lbuffers.emplace_back(lbuffer);
-        }
-        lupdater->lbuffer_ids.clear();
-      }
-    }
-
-    if (lreality_viewer->llocate_space) {
-      auto& llocate_space = lreality_viewer->llocate_space;
-      for (auto& lspace_id : llocate_space->lspace_ids) {
-        const auto it = node_id_map.find(lspace_id);
-        assert(it != node_id_map.end());
-        auto lspace = std::static_pointer_cast<LayoutBase>(it->second);
-        assert(lspace);
-        llocate_space->lspaces.emplace_back(lspace);
-      }
-      llocate_space->lspace_ids.clear();
-    }
-
-    if (lreality_viewer->lend_frame) {
-      auto& lend_frame = lreality_viewer->lend_frame;
-      for (auto& llayer_id : lend_frame->llayer_ids) {
-        const auto it = node_id_map.find(llayer_id);
-        assert(it != node_id_map.end());
-        auto llayer = std::static_pointer_cast<LayoutBase>(it->second);
-        assert(llayer);
-        lend_frame->llayers.emplace_back(llayer);
-      }
-      lend_frame->llayer_ids.clear();
-    }
-  }
-
-#endif  // XG_ENABLE_REALITY
+  return true;
 }
 
 }  // namespace xg
@@ -33,12 +33,15 @@ bool ParserSingleton<ParserAcquireNextImage>::ParseElement(
   }
 #endif  // XG_ENABLE_REALITY
 
-  node->lwait_fence_id = element->Attribute("waitFence");
+  node->lwait_fence_id =
+      AddReference(node, &node->lwait_fence, element->Attribute("waitFence"));
 
   element->QueryUnsigned64Attribute("timeout", &node->timeout);
 
-  node->lsemaphore_id = element->Attribute("semaphore");
-  node->lfence_id = element->Attribute("fence");
+  node->lsemaphore_id =
+      AddReference(node, &node->lsemaphore, element->Attribute("semaphore"));
+  node->lfence_id =
+      AddReference(node, &node->lfence, element->Attribute("fence"));
 
   status->node = node;
 
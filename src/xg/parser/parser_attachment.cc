@@ -51,7 +51,8 @@ bool ParserSingleton<ParserAttachment>::ParseElement(
   value = element->Attribute("finalLayout");
   if (value) node->final_layout = StringToImageLayout(value);
 
-  node->lswapchain_id = element->Attribute("swapchain");
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
 
   status->node = node;
 
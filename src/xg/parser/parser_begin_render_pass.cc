@@ -28,8 +28,10 @@ bool ParserSingleton<ParserBeginRenderPass>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->lrender_pass_id = element->Attribute("renderPass");
-  node->lframebuffer_id = element->Attribute("framebuffer");
+  node->lrender_pass_id =
+      AddReference(node, &node->lrender_pass, element->Attribute("renderPass"));
+  node->lframebuffer_id = AddReference(node, &node->lframebuffer,
+                                       element->Attribute("framebuffer"));
 
   for (auto child = element->FirstChildElement(); child;
        child = child->NextSiblingElement()) {
@@ -32,7 +32,7 @@ bool ParserSingleton<ParserBindDescriptorSets>::ParseElement(
   if (value) node->pipeline_bind_point = StringToPipelineBindPoint(value);
 
   value = element->Attribute("layout");
-  if (value) node->llayout_id = value;
+  node->llayout_id = AddReference(node, &node->layout, value);
 
   element->QueryIntAttribute("firstSet", &node->first_set);
 
@@ -42,7 +42,10 @@ bool ParserSingleton<ParserBindDescriptorSets>::ParseElement(
 
     if (strcmp(name, "DescriptorSet") == 0) {
       value = child->Attribute("descriptorSet");
-      if (value) node->ldesc_set_ids.emplace_back(value);
+      if (value) {
+        node->ldesc_set_ids.emplace_back(
+            AddReference(node, &node->ldesc_sets, value));
+      }
     } else if (strcmp(name, "DynamicOffset") == 0) {
       LayoutDynamicOffset ldynamic_offset;
 
@@ -64,6 +67,11 @@ bool ParserSingleton<ParserBindDescriptorSets>::ParseElement(
     }
   }
 
+  for (auto& ldynamic_offset : node->ldynamic_offsets) {
+    ldynamic_offset.lbuffer_id = AddReference(node, &ldynamic_offset.lbuffer,
+                                              ldynamic_offset.lbuffer_id);
+  }
+
   status->node = node;
 
   return ParserBase::Get().ParseElement(element, status);
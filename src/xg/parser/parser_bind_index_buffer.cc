@@ -32,7 +32,8 @@ bool ParserSingleton<ParserBindIndexBuffer>::ParseElement(
   element->QueryIntAttribute("offset", &offset);
   node->offset = offset;
 
-  node->lbuffer_id = element->Attribute("buffer");
+  node->lbuffer_id =
+      AddReference(node, &node->lbuffer, element->Attribute("buffer"));
 
   const char* value = element->Attribute("indexType");
   if (value) node->index_type = StringToIndexType(value);
@@ -28,7 +28,8 @@ bool ParserSingleton<ParserBindPipeline>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->lpipeline_id = element->Attribute("pipeline");
+  node->lpipeline_id =
+      AddReference(node, &node->lpipeline, element->Attribute("pipeline"));
 
   status->node = node;
 
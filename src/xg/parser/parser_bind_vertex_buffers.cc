@@ -36,7 +36,10 @@ bool ParserSingleton<ParserBindVertexBuffers>::ParseElement(
 
     if (strcmp(name, "Buffer") == 0) {
       const char* value = child->Attribute("buffer");
-      if (value) node->lbuffer_ids.emplace_back(value);
+      if (value) {
+        node->lbuffer_ids.emplace_back(
+            AddReference(node, &node->lbuffers, value));
+      }
 
       int offset = 0;
       element->QueryIntAttribute("offset", &offset);
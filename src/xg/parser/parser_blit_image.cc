@@ -27,10 +27,14 @@ bool ParserSingleton<ParserBlitImage>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->lsrc_image_id = element->Attribute("srcImage");
-  node->lsrc_swapchain_id = element->Attribute("srcSwapchain");
-  node->ldst_image_id = element->Attribute("dstImage");
-  node->ldst_swapchain_id = element->Attribute("dstSwapchain");
+  node->lsrc_image_id =
+      AddReference(node, &node->lsrc_image, element->Attribute("srcImage"));
+  node->lsrc_swapchain_id = AddReference(node, &node->lsrc_swapchain,
+                                         element->Attribute("srcSwapchain"));
+  node->ldst_image_id =
+      AddReference(node, &node->ldst_image, element->Attribute("dstImage"));
+  node->ldst_swapchain_id = AddReference(node, &node->ldst_swapchain,
+                                         element->Attribute("dstSwapchain"));
 
   const char* value = element->Attribute("srcImageLayout");
   if (value) node->src_image_layout = StringToImageLayout(value);
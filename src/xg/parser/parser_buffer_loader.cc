@@ -8,10 +8,12 @@
 
 #include "xg/parser/parser_internal.h"
 
+#include <cstdint>
 #include <memory>
 
 #include "tinyxml2.h"
 #include "xg/layout.h"
+#include "xg/logger.h"
 #include "xg/types.h"
 
 namespace xg {
@@ -23,18 +25,29 @@ bool ParserSingleton<ParserBufferLoader>::ParseElement(
   auto node = std::make_shared<LayoutBufferLoader>();
   if (!node) return false;
 
-  node->lbuffer_id = element->Attribute("buffer");
-  node->lqueue_id = element->Attribute("queue");
+  node->lbuffer_id =
+      AddReference(node, &node->lbuffer, element->Attribute("buffer"));
+  node->lqueue_id =
+      AddReference(node, &node->lqueue, element->Attribute("queue"));
 
   const char* value = element->Attribute("file");
   if (value) node->file = value;
 
-  int offset = 0;
-  element->QueryIntAttribute("srcOffset", &offset);
-  node->src_offset = offset;
-
-  element->QueryIntAttribute("dstOffset", &offset);
-  node->dst_offset = offset;
+  int64_t offset = 0;
+  element->QueryInt64Attribute("srcOffset", &offset);
+  if (offset < 0) {
+    XG_ERROR("invalid buffer loader src offset: {}", offset);
+    return false;
+  }
+  node->src_offset = static_cast<size_t>(offset);
+
+  offset = 0;
+  element->QueryInt64Attribute("dstOffset", &offset);
+  if (offset < 0) {
+    XG_ERROR("invalid buffer loader dst offset: {}", offset);
+    return false;
+  }
+  node->dst_offset = static_cast<size_t>(offset);
 
   value = element->Attribute("size");
   if (value) node->size = static_cast<int>(Expression::Get().Evaluate(value));
@@ -45,7 +58,7 @@ bool ParserSingleton<ParserBufferLoader>::ParseElement(
   value = element->Attribute("stageMask");
   if (value) node->stage_mask = StringToPipelineStageFlags(value);
 
-  node->ldata_id = element->Attribute("data");
+  node->ldata_id = AddReference(node, &node->ldata, element->Attribute("data"));
 
   status->node = node;
 
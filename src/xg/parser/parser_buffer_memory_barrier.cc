@@ -28,7 +28,8 @@ bool ParserSingleton<ParserBufferMemoryBarrier>::ParseElement(
       std::static_pointer_cast<LayoutPipelineBarrier>(status->parent);
   lpipeline_barrier->lbuffer_memory_barriers.emplace_back(node);
 
-  node->lbuffer_id = element->Attribute("buffer");
+  node->lbuffer_id =
+      AddReference(node, &node->lbuffer, element->Attribute("buffer"));
 
   const char* value = element->Attribute("offset");
   if (value)
@@ -46,13 +47,15 @@ bool ParserSingleton<ParserBufferMemoryBarrier>::ParseElement(
       value = child->Attribute("accessMask");
       if (value) node->src_access_mask = StringToAccessFlags(value);
 
-      node->lsrc_queue_id = child->Attribute("queue");
+      node->lsrc_queue_id =
+          AddReference(node, &node->lsrc_queue, child->Attribute("queue"));
 
     } else if (strcmp(name, "Destination") == 0) {
       value = child->Attribute("accessMask");
       if (value) node->dst_access_mask = StringToAccessFlags(value);
 
-      node->ldst_queue_id = child->Attribute("queue");
+      node->ldst_queue_id =
+          AddReference(node, &node->ldst_queue, child->Attribute("queue"));
     }
   }
 
@@ -23,7 +23,8 @@ bool ParserSingleton<ParserCamera>::ParseElement(
   auto node = std::make_shared<LayoutCamera>();
   if (!node) return false;
 
-  node->lswapchain_id = element->Attribute("swapchain");
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
 
   for (auto child = element->FirstChildElement(); child;
        child = child->NextSiblingElement()) {
@@ -28,7 +28,7 @@ bool ParserSingleton<ParserColorAttachment>::ParseElement(
   node->lsubpass = lsubpass;
   lsubpass->lcolor_attachments.emplace_back(node);
 
-  node->lattachment_id = element->Attribute("attachment");
+  node->lattachment_id = InternId(element->Attribute("attachment"));
 
   const char* value = element->Attribute("layout");
   if (value) node->layout = StringToImageLayout(value);
@@ -30,7 +30,8 @@ bool ParserSingleton<ParserCommandBuffer>::ParseElement(
     if (status->parent->layout_type == LayoutType::kFrame) {
       node->lframe = std::static_pointer_cast<LayoutFrame>(status->parent);
     }
-    node->lcmd_pool_id = element->Attribute("commandPool");
+    node->lcmd_pool_id =
+        AddReference(node, &node->lcmd_pool, element->Attribute("commandPool"));
   }
 
   status->node = node;
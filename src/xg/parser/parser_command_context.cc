@@ -26,7 +26,8 @@ bool ParserSingleton<ParserCommandContext>::ParseElement(
     auto lwin_viewer = static_cast<LayoutWindowViewer*>(status->parent.get());
     const char* value = element->Attribute("commandContext");
     if (value) {
-      lwin_viewer->lcmd_context_ids.emplace_back(value);
+      lwin_viewer->lcmd_context_ids.emplace_back(
+          AddReference(status->parent, &lwin_viewer->lcmd_contexts, value));
       return false;
     } else {
       lwin_viewer->lcmd_contexts.emplace_back(node);
@@ -37,7 +38,8 @@ bool ParserSingleton<ParserCommandContext>::ParseElement(
     auto lview = static_cast<LayoutView*>(status->parent.get());
     const char* value = element->Attribute("commandContext");
     if (value) {
-      lview->lcmd_context_ids.emplace_back(value);
+      lview->lcmd_context_ids.emplace_back(
+          AddReference(status->parent, &lview->lcmd_contexts, value));
       return false;
     } else {
       lview->lcmd_contexts.emplace_back(node);
@@ -45,8 +47,10 @@ bool ParserSingleton<ParserCommandContext>::ParseElement(
   }
 #endif  // XG_ENABLE_REALITY
 
-  node->lcmd_group_id = element->Attribute("commandGroup");
-  node->lcmd_buffer_id = element->Attribute("commandBuffer");
+  node->lcmd_group_id =
+      AddReference(node, &node->lcmd_group, element->Attribute("commandGroup"));
+  node->lcmd_buffer_id = AddReference(node, &node->lcmd_buffer,
+                                      element->Attribute("commandBuffer"));
   element->QueryBoolAttribute("dynamic", &node->dynamic);
 
   status->node = node;
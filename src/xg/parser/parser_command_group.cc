@@ -30,7 +30,9 @@ bool ParserSingleton<ParserCommandGroup>::ParseElement(
     const char* value = element->Attribute("commandGroup");
     if (value) {
       lcmd_group->lcmd_nodes.emplace_back(std::shared_ptr<LayoutBase>());
-      lcmd_group->lcmd_node_ids.emplace_back(value);
+      lcmd_group->lcmd_node_ids.emplace_back(
+          AddReference(lcmd_group, &lcmd_group->lcmd_nodes,
+                       lcmd_group->lcmd_nodes.size() - 1, value));
       return false;
     } else {
       lcmd_group->lcmd_nodes.emplace_back(node);
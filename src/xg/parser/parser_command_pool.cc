@@ -26,7 +26,8 @@ bool ParserSingleton<ParserCommandPool>::ParseElement(
   if (status->parent->layout_type == LayoutType::kQueue) {
     node->lqueue = std::static_pointer_cast<LayoutQueue>(status->parent);
   } else {
-    node->lqueue_id = element->Attribute("queue");
+    node->lqueue_id =
+        AddReference(node, &node->lqueue, element->Attribute("queue"));
   }
 
   status->node = node;
@@ -23,7 +23,8 @@ bool ParserSingleton<ParserComputePipeline>::ParseElement(
   auto node = std::make_shared<LayoutComputePipeline>();
   if (!node) return false;
 
-  node->llayout_id = element->Attribute("layout");
+  node->llayout_id =
+      AddReference(node, &node->llayout, element->Attribute("layout"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
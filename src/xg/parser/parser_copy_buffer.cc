@@ -27,8 +27,10 @@ bool ParserSingleton<ParserCopyBuffer>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->lsrc_buffer_id = element->Attribute("srcBuffer");
-  node->ldst_buffer_id = element->Attribute("dstBuffer");
+  node->lsrc_buffer_id =
+      AddReference(node, &node->lsrc_buffer, element->Attribute("srcBuffer"));
+  node->ldst_buffer_id =
+      AddReference(node, &node->ldst_buffer, element->Attribute("dstBuffer"));
 
   for (auto child = element->FirstChildElement(); child;
        child = child->NextSiblingElement()) {
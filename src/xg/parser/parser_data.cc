@@ -8,72 +8,170 @@
 
 #include "xg/parser/parser_internal.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "tinyxml2.h"
 #include "xg/layout.h"
+#include "xg/logger.h"
 #include "xg/types.h"
 
 namespace xg {
 namespace parser {
 
+template <typename T>
+static void AppendIntegers(std::string_view text, std::vector<uint8_t>* data) {
+  std::vector<T> values;
+  StringToIntegers(text, &values);
+  const auto bytes = reinterpret_cast<const uint8_t*>(values.data());
+  data->insert(data->end(), &bytes[0], &bytes[values.size() * sizeof(T)]);
+}
+
+static void AppendFloats(std::string_view text, std::vector<uint8_t>* data) {
+  std::vector<float> values;
+  StringToFloats(text, &values);
+  const auto bytes = reinterpret_cast<const uint8_t*>(values.data());
+  data->insert(data->end(), &bytes[0], &bytes[values.size() * sizeof(float)]);
+}
+
+bool AppendDataValues(std::string_view type, std::string_view text,
+                      std::vector<uint8_t>* data) {
+  using AppendFunc = void (*)(std::string_view, std::vector<uint8_t>*);
+  static constexpr auto mapping = MakeStringTable<AppendFunc>({
+      {"Int32Values", AppendIntegers<int32_t>},
+      {"UInt32Values", AppendIntegers<uint32_t>},
+      {"UInt16Values", AppendIntegers<uint16_t>},
+      {"UInt8Values", AppendIntegers<uint8_t>},
+      {"FloatValues", AppendFloats},
+  });
+
+  const auto x = mapping.find(type);
+  if (x == std::end(mapping)) return false;
+
+  x->second(text, data);
+  return true;
+}
+
+// a generated element is at most this many values
+static constexpr int64_t kMaxGenerateCount = int64_t{1} << 28;
+
+// saturates to the range of T, NaN stores 0
+template <typename T>
+static void StoreValue(double value, uint8_t* dst) {
+  using Limits = std::numeric_limits<T>;
+  const auto clamped = std::isnan(value)
+                           ? 0.0
+                           : std::clamp(value, double{Limits::lowest()},
+                                        double{Limits::max()});
+  const auto x = static_cast<T>(clamped);
+  std::memcpy(dst, &x, sizeof(x));
+}
+
+bool AppendGeneratedValues(const tinyxml2::XMLElement* element,
+                           std::vector<uint8_t>* data) {
+  struct Store {
+    Expression::StoreFunc func;
+    size_t size;
+  };
+  static constexpr auto mapping = MakeStringTable<Store>({
+      {"Int32", {StoreValue<int32_t>, sizeof(int32_t)}},
+      {"UInt32", {StoreValue<uint32_t>, sizeof(uint32_t)}},
+      {"UInt16", {StoreValue<uint16_t>, sizeof(uint16_t)}},
+      {"UInt8", {StoreValue<uint8_t>, sizeof(uint8_t)}},
+      {"Float", {StoreValue<float>, sizeof(float)}},
+  });
+
+  const char* value = element->Attribute("type");
+  const auto x = mapping.find(value ? value : "Float");
+  if (x == std::end(mapping)) {
+    XG_ERROR("unknown generate type: {}", value);
+    return false;
+  }
+
+  int64_t count = 0;
+  value = element->Attribute("count");
+  if (value && !StringToLiteral(value, &count)) {
+    const auto evaluated = Expression::Get().Evaluate(value);
+    count = evaluated >= 0.0f && evaluated <= kMaxGenerateCount
+                ? static_cast<int64_t>(evaluated)
+                : -1;
+  }
+
+  const char* expr = element->Attribute("expr");
+  if (!expr || count < 0) {
+    XG_ERROR("invalid generate element");
+    return false;
+  }
+
+  const auto offset = data->size();
+  const auto size = static_cast<size_t>(count) * x->second.size;
+  if (count > kMaxGenerateCount || size > data->max_size() - offset) {
+    XG_ERROR("generate count too large: {}", count);
+    return false;
+  }
+  data->resize(offset + size);
+  if (!Expression::Get().Generate(expr, static_cast<size_t>(count),
+                                  x->second.size, x->second.func,
+                                  data->data() + offset)) {
+    XG_ERROR("invalid generate expression: {}", expr);
+    data->resize(offset);
+    return false;
+  }
+  return true;
+}
+
 template <>
 bool ParserSingleton<ParserData>::ParseElement(
     const tinyxml2::XMLElement* element, ParserStatus* status) {
   auto node = std::make_shared<LayoutData>();
   if (!node) return false;
 
-  for (auto child = element->FirstChildElement(); child;
-       child = child->NextSiblingElement()) {
-    const char* name = child->Name();
+  const char* value = element->Attribute("file");
+  if (value) {
+    Dependencies::Get().Add(value);
+    node->file = value;
 
-    if (strcmp(name, "Int32Values") == 0) {
-      const char* text = child->GetText();
-      if (text) {
-        std::vector<int32_t> values;
-        StringToIntegers(text, &values);
-        const auto data = reinterpret_cast<const uint8_t*>(values.data());
-        node->data.insert(node->data.end(), &data[0],
-                          &data[values.size() * sizeof(int32_t)]);
-      }
-    } else if (strcmp(name, "UInt32Values") == 0) {
-      const char* text = child->GetText();
-      if (text) {
-        std::vector<uint32_t> values;
-        StringToIntegers(text, &values);
-        const auto data = reinterpret_cast<const uint8_t*>(values.data());
-        node->data.insert(node->data.end(), &data[0],
-                          &data[values.size() * sizeof(uint32_t)]);
+    int64_t offset = 0;
+    if (element->QueryInt64Attribute("offset", &offset) ==
+        tinyxml2::XML_SUCCESS) {
+      if (offset < 0) {
+        XG_ERROR("invalid data offset: {}", offset);
+        return false;
       }
-    } else if (strcmp(name, "UInt16Values") == 0) {
-      const char* text = child->GetText();
-      if (text) {
-        std::vector<uint16_t> values;
-        StringToIntegers(text, &values);
-        const auto data = reinterpret_cast<const uint8_t*>(values.data());
-        node->data.insert(node->data.end(), &data[0],
-                          &data[values.size() * sizeof(uint16_t)]);
+      node->offset = static_cast<size_t>(offset);
+    }
+
+    int64_t size = 0;
+    if (element->QueryInt64Attribute("size", &size) == tinyxml2::XML_SUCCESS) {
+      if (size < 0) {
+        XG_ERROR("invalid data size: {}", size);
+        return false;
       }
-    } else if (strcmp(name, "UInt8Values") == 0) {
-      const char* text = child->GetText();
-      if (text) {
-        std::vector<uint8_t> values;
-        StringToIntegers(text, &values);
-        node->data.insert(node->data.end(), values.begin(), values.end());
+      node->size = static_cast<size_t>(size);
+    }
+  } else {
+    std::vector<uint8_t> data;
+
+    for (auto child = element->FirstChildElement(); child;
+         child = child->NextSiblingElement()) {
+      if (std::strcmp(child->Name(), "Generate") == 0) {
+        if (!AppendGeneratedValues(child, &data)) return false;
+        continue;
       }
-    } else if (strcmp(name, "FloatValues") == 0) {
+
       const char* text = child->GetText();
-      if (text) {
-        std::vector<float> values;
-        StringToFloats(text, &values);
-        const auto data = reinterpret_cast<const uint8_t*>(values.data());
-        node->data.insert(node->data.end(), &data[0],
-                          &data[values.size() * sizeof(float)]);
-      }
+      if (text) AppendDataValues(child->Name(), text, &data);
     }
+    node->data = ParseContext::GetCurrent()->InternBlob(
+        std::make_shared<LayoutBlob>(std::move(data)));
   }
 
   status->node = node;
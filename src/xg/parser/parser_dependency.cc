@@ -34,7 +34,7 @@ bool ParserSingleton<ParserDependency>::ParseElement(
     const char* name = child->Name();
 
     if (strcmp(name, "Source") == 0) {
-      node->lsrc_subpass_id = child->Attribute("subpass");
+      node->lsrc_subpass_id = InternId(child->Attribute("subpass"));
 
       const char* value = child->Attribute("stageMask");
       if (value) node->src_stage_mask = StringToPipelineStageFlags(value);
@@ -43,7 +43,7 @@ bool ParserSingleton<ParserDependency>::ParseElement(
       if (value) node->src_access_mask = StringToAccessFlags(value);
 
     } else if (strcmp(name, "Destination") == 0) {
-      node->ldst_subpass_id = child->Attribute("subpass");
+      node->ldst_subpass_id = InternId(child->Attribute("subpass"));
 
       const char* value = child->Attribute("stageMask");
       if (value) node->dst_stage_mask = StringToPipelineStageFlags(value);
@@ -28,7 +28,7 @@ bool ParserSingleton<ParserDepthStencilAttachment>::ParseElement(
   node->lsubpass = lsubpass;
   lsubpass->ldepth_stencil_attachment = node;
 
-  node->lattachment_id = element->Attribute("attachment");
+  node->lattachment_id = InternId(element->Attribute("attachment"));
 
   const char* value = element->Attribute("layout");
   if (value) node->layout = StringToImageLayout(value);
@@ -35,7 +35,8 @@ bool ParserSingleton<ParserDescriptorBufferInfo>::ParseElement(
   if (value)
     node->range = static_cast<size_t>(Expression::Get().Evaluate(value));
 
-  node->lbuffer_id = element->Attribute("buffer");
+  node->lbuffer_id =
+      AddReference(node, &node->lbuffer, element->Attribute("buffer"));
 
   status->node = node;
 
@@ -27,8 +27,10 @@ bool ParserSingleton<ParserDescriptorImageInfo>::ParseElement(
   auto ldesc = static_cast<LayoutDescriptor*>(status->parent.get());
   ldesc->ldesc_image_infos.emplace_back(node);
 
-  node->lsampler_id = element->Attribute("sampler");
-  node->limage_view_id = element->Attribute("imageView");
+  node->lsampler_id =
+      AddReference(node, &node->lsampler, element->Attribute("sampler"));
+  node->limage_view_id =
+      AddReference(node, &node->limage_view, element->Attribute("imageView"));
 
   const char* value = element->Attribute("imageLayout");
   if (value) node->image_layout = StringToImageLayout(value);
@@ -29,10 +29,12 @@ bool ParserSingleton<ParserDescriptorSet>::ParseElement(
     if (status->parent->layout_type == LayoutType::kFrame) {
       node->lframe = std::static_pointer_cast<LayoutFrame>(status->parent);
     }
-    node->ldesc_pool_id = element->Attribute("descriptorPool");
+    node->ldesc_pool_id = AddReference(node, &node->ldesc_pool,
+                                       element->Attribute("descriptorPool"));
   }
 
-  node->lset_layout_id = element->Attribute("setLayout");
+  node->lset_layout_id =
+      AddReference(node, &node->lset_layout, element->Attribute("setLayout"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
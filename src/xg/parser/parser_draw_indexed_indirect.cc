@@ -28,7 +28,8 @@ bool ParserSingleton<ParserDrawIndexedIndirect>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->lbuffer_id = element->Attribute("buffer");
+  node->lbuffer_id =
+      AddReference(node, &node->lbuffer, element->Attribute("buffer"));
 
   const char* value = element->Attribute("offset");
   if (value) {
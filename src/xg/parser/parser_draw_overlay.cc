@@ -28,7 +28,8 @@ bool ParserSingleton<ParserDrawOverlay>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->loverlay_id = element->Attribute("overlay");
+  node->loverlay_id =
+      AddReference(node, &node->loverlay, element->Attribute("overlay"));
 
   status->node = node;
 
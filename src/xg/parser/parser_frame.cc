@@ -23,7 +23,8 @@ bool ParserSingleton<ParserFrame>::ParseElement(
   auto node = std::make_shared<LayoutFrame>();
   if (!node) return false;
 
-  node->lswapchain_id = element->Attribute("swapchain");
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
 
   const char* value = element->Attribute("frameCount");
   if (value) node->frame_count = static_cast<int>(Expression::Get().Evaluate(value));
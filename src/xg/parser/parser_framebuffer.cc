@@ -27,8 +27,15 @@ bool ParserSingleton<ParserFramebuffer>::ParseElement(
     node->lframe = std::static_pointer_cast<LayoutFrame>(status->parent);
   }
 
-  node->lrender_pass_id = element->Attribute("renderPass");
+  node->lrender_pass_id =
+      AddReference(node, &node->lrender_pass, element->Attribute("renderPass"));
   node->lswapchain_id = element->Attribute("swapchain");
+  if (node->lrender_pass_id) {
+    node->lswapchain_id =
+        AddReference(node, &node->lswapchain, node->lswapchain_id);
+  } else {
+    node->lswapchain_id = InternId(node->lswapchain_id);
+  }
 
   const char* value = element->Attribute("width");
   if (value) node->width = Expression::Get().Evaluate(value);
@@ -52,6 +59,17 @@ bool ParserSingleton<ParserFramebuffer>::ParseElement(
     }
   }
 
+  for (auto& lattachment : node->lattachments) {
+    if (lattachment.limage_view_id) {
+      lattachment.limage_view_id = AddReference(
+          node, &lattachment.limage_view, lattachment.limage_view_id);
+      lattachment.lswapchain_id = InternId(lattachment.lswapchain_id);
+    } else {
+      lattachment.lswapchain_id = AddReference(
+          node, &lattachment.lswapchain, lattachment.lswapchain_id);
+    }
+  }
+
   status->node = node;
 
   return ParserBase::Get().ParseElement(element, status);
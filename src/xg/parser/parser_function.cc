@@ -30,7 +30,7 @@ bool ParserSingleton<ParserFunction>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->ldata_id = element->Attribute("data");
+  node->ldata_id = AddReference(node, &node->ldata, element->Attribute("data"));
 
   status->node = node;
 
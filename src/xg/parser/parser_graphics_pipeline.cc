@@ -23,9 +23,11 @@ bool ParserSingleton<ParserGraphicsPipeline>::ParseElement(
   auto node = std::make_shared<LayoutGraphicsPipeline>();
   if (!node) return false;
 
-  node->llayout_id = element->Attribute("layout");
-  node->lrender_pass_id = element->Attribute("renderPass");
-  node->lsubpass_id = element->Attribute("subpass");
+  node->llayout_id =
+      AddReference(node, &node->llayout, element->Attribute("layout"));
+  node->lrender_pass_id =
+      AddReference(node, &node->lrender_pass, element->Attribute("renderPass"));
+  node->lsubpass_id = InternId(element->Attribute("subpass"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
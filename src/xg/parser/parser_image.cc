@@ -60,7 +60,8 @@ bool ParserSingleton<ParserImage>::ParseElement(
   value = element->Attribute("initialLayout");
   if (value) node->initial_layout = StringToImageLayout(value);
 
-  node->lswapchain_id = element->Attribute("swapchain");
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
 
   status->node = node;
 
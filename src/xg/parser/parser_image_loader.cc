@@ -23,8 +23,10 @@ bool ParserSingleton<ParserImageLoader>::ParseElement(
   auto node = std::make_shared<LayoutImageLoader>();
   if (!node) return false;
 
-  node->limage_id = element->Attribute("image");
-  node->lqueue_id = element->Attribute("queue");
+  node->limage_id =
+      AddReference(node, &node->limage, element->Attribute("image"));
+  node->lqueue_id =
+      AddReference(node, &node->lqueue, element->Attribute("queue"));
 
   const char* value = element->Attribute("file");
   if (value) node->file = value;
@@ -28,8 +28,10 @@ bool ParserSingleton<ParserImageMemoryBarrier>::ParseElement(
       std::static_pointer_cast<LayoutPipelineBarrier>(status->parent);
   lpipeline_barrier->limage_memory_barriers.emplace_back(node);
 
-  node->limage_id = element->Attribute("image");
-  node->lswapchain_id = element->Attribute("swapchain");
+  node->limage_id =
+      AddReference(node, &node->limage, element->Attribute("image"));
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
 
   const char* value = element->Attribute("aspectMask");
   if (value)
@@ -55,7 +57,8 @@ bool ParserSingleton<ParserImageMemoryBarrier>::ParseElement(
       value = child->Attribute("layout");
       if (value) node->old_layout = StringToImageLayout(value);
 
-      node->lsrc_queue_id = child->Attribute("queue");
+      node->lsrc_queue_id =
+          AddReference(node, &node->lsrc_queue, child->Attribute("queue"));
 
     } else if (strcmp(name, "Destination") == 0) {
       value = child->Attribute("accessMask");
@@ -64,7 +67,8 @@ bool ParserSingleton<ParserImageMemoryBarrier>::ParseElement(
       value = child->Attribute("layout");
       if (value) node->new_layout = StringToImageLayout(value);
 
-      node->ldst_queue_id = child->Attribute("queue");
+      node->ldst_queue_id =
+          AddReference(node, &node->ldst_queue, child->Attribute("queue"));
     }
   }
 
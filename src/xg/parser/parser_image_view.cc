@@ -26,7 +26,8 @@ bool ParserSingleton<ParserImageView>::ParseElement(
   if (status->parent->layout_type == LayoutType::kImage) {
     node->limage = std::static_pointer_cast<LayoutImage>(status->parent);
   } else {
-    node->limage_id = element->Attribute("image");
+    node->limage_id =
+        AddReference(node, &node->limage, element->Attribute("image"));
   }
 
   const char* value = element->Attribute("viewType");
@@ -9,9 +9,16 @@
 #ifndef XG_PARSER_PARSER_INTERNAL_H_
 #define XG_PARSER_PARSER_INTERNAL_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
-#include <sstream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "glm/glm.hpp"
@@ -22,26 +29,277 @@
 namespace xg {
 namespace parser {
 
-class Expression {
+template <typename T>
+struct StringTableEntry {
+  std::string_view first;
+  T second;
+};
+
+// Maps names to values. The entries are sorted at compile time and looked up
+// with a binary search, so nothing is allocated at run time.
+template <typename T, size_t N>
+class StringTable {
  public:
-  static Expression& Get() {
-    static Expression expression;
-    return expression;
+  constexpr explicit StringTable(const StringTableEntry<T> (&entries)[N])
+      : entries_{} {
+    for (size_t i = 0; i < N; ++i) {
+      auto j = i;
+      for (; j > 0 && entries[i].first < entries_[j - 1].first; --j) {
+        entries_[j] = entries_[j - 1];
+      }
+      entries_[j] = entries[i];
+    }
   }
 
-  void Reset();
-  void AddConstant(const char* name, float value);
-  float Evaluate(const char* expr);
+  const StringTableEntry<T>* find(std::string_view name) const {
+    const auto x = std::lower_bound(
+        begin(), end(), name,
+        [](const StringTableEntry<T>& entry, std::string_view name) {
+          return entry.first < name;
+        });
+    return x != end() && x->first == name ? x : end();
+  }
+
+  const StringTableEntry<T>* begin() const { return entries_; }
+  const StringTableEntry<T>* end() const { return entries_ + N; }
 
  private:
+  StringTableEntry<T> entries_[N];
+};
+
+template <typename T, size_t N>
+constexpr StringTable<T, N> MakeStringTable(
+    const StringTableEntry<T> (&entries)[N]) {
+  return StringTable<T, N>(entries);
+}
+
+// Evaluates the expressions of one parse against the constants it defined.
+class Expression {
+ public:
+  // Returns the expression of the parse running on this thread.
+  static Expression& Get();
+
   Expression();
   ~Expression();
+
+  using StoreFunc = void (*)(double value, uint8_t* dst);
+
+  void AddConstant(const char* name, float value);
+  float Evaluate(const char* expr);
+
+  // Evaluates |expr| for each index variable i in [0, count) and stores the
+  // values |stride| bytes apart from |dst|. The range is split across the
+  // thread pool unless called from a worker. It is evaluated in double, so
+  // that every index and every 32 bit integer value is exact.
+  bool Generate(const char* expr, size_t count, size_t stride,
+                StoreFunc store, uint8_t* dst);
+  size_t GetCacheHits() const { return cache_hits_; }
+  size_t GetCacheMisses() const { return cache_misses_; }
+
+ private:
   Expression(const Expression&) = delete;
   Expression& operator=(const Expression&) = delete;
   Expression(Expression&&) = delete;
   Expression& operator=(Expression&&) = delete;
+
+  struct Impl;
+
+  std::mutex mutex_;
+  std::unique_ptr<Impl> impl_;
+  uint64_t generation_ = 1;
+  size_t cache_hits_ = 0;
+  size_t cache_misses_ = 0;
+};
+
+// Collects the files besides the xml that a layout is parsed from, which
+// decide whether a cached layout is still valid.
+class Dependencies {
+ public:
+  // Returns the dependencies of the parse running on this thread.
+  static Dependencies& Get();
+
+  Dependencies() = default;
+
+  void Add(const char* filepath);
+  std::vector<std::string> GetFiles();
+
+ private:
+  Dependencies(const Dependencies&) = delete;
+  Dependencies& operator=(const Dependencies&) = delete;
+  Dependencies(Dependencies&&) = delete;
+  Dependencies& operator=(Dependencies&&) = delete;
+
+  std::mutex mutex_;
+  std::vector<std::string> files_;
+};
+
+// The state of one parse. Every thread working on a parse makes its context
+// current, so the element parsers reach it without it being passed around
+// and several layouts can be parsed at the same time.
+class ParseContext {
+ public:
+  static ParseContext* GetCurrent();
+
+  ParseContext() = default;
+
+  Expression& GetExpression() { return expression_; }
+  Dependencies& GetDependencies() { return dependencies_; }
+
+  // Keeps an included fragment alive until the parse finishes, as the ids
+  // of its nodes are interned in it.
+  void KeepFragment(std::shared_ptr<void> fragment);
+
+  // Ids are interned into dense handles as they are parsed. A reference is
+  // recorded as the handle of its id and the slot it is resolved into, and
+  // keeps |owner|, the node holding the slot, alive until it is resolved.
+  // They return the interned copy of |id|, which lives as long as the
+  // context, or nullptr for an absent reference.
+  template <typename T>
+  const char* AddReference(std::shared_ptr<void> owner,
+                           std::shared_ptr<T>* slot, const char* id) {
+    if (!id) return nullptr;
+    return RecordReference(id, std::shared_ptr<void>(std::move(owner), slot),
+                           0, Assign<T>);
+  }
+
+  // Appends the node to |slots| after the nodes already there. The
+  // references of one owner are appended in the order they are added.
+  template <typename T>
+  const char* AddReference(std::shared_ptr<void> owner,
+                           std::vector<std::shared_ptr<T>>* slots,
+                           const char* id) {
+    if (!id) return nullptr;
+    return RecordReference(id, std::shared_ptr<void>(std::move(owner), slots),
+                           0, AppendElement<T>);
+  }
+
+  // Assigns the node to the existing (*slots)[index].
+  template <typename T>
+  const char* AddReference(std::shared_ptr<void> owner,
+                           std::vector<std::shared_ptr<T>>* slots,
+                           size_t index, const char* id) {
+    if (!id) return nullptr;
+    return RecordReference(id, std::shared_ptr<void>(std::move(owner), slots),
+                           index, AssignElement<T>);
+  }
+
+  // Returns the interned copy of an id that is kept but not resolved.
+  const char* InternId(const char* id);
+
+  // Makes |node| the target of the references to its id.
+  void AddNode(std::shared_ptr<LayoutBase> node);
+
+  // Assigns the recorded references in one pass over the handles. Returns
+  // false if any of them has no node.
+  bool ResolveReferences();
+
+  // Returns an earlier blob with the same content as |blob|, or |blob| if
+  // there is none, so that equal data and shader code are stored once.
+  std::shared_ptr<LayoutBlob> InternBlob(std::shared_ptr<LayoutBlob> blob);
+  size_t GetSavedBlobBytes() const { return saved_blob_bytes_; }
+
+  // Makes a context current on this thread for the lifetime of the scope.
+  class Scope {
+   public:
+    explicit Scope(ParseContext* context);
+    ~Scope();
+
+   private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ParseContext* previous_;
+  };
+
+ private:
+  ParseContext(const ParseContext&) = delete;
+  ParseContext& operator=(const ParseContext&) = delete;
+  ParseContext(ParseContext&&) = delete;
+  ParseContext& operator=(ParseContext&&) = delete;
+
+  using AssignFunc = void (*)(void* slot, size_t index,
+                              const std::shared_ptr<LayoutBase>& node);
+
+  struct Reference {
+    uint32_t handle;
+    size_t index;
+    std::shared_ptr<void> slot;
+    AssignFunc assign;
+  };
+
+  template <typename T>
+  static void Assign(void* slot, size_t index,
+                     const std::shared_ptr<LayoutBase>& node) {
+    *static_cast<std::shared_ptr<T>*>(slot) = std::static_pointer_cast<T>(node);
+  }
+
+  template <typename T>
+  static void AssignElement(void* slots, size_t index,
+                            const std::shared_ptr<LayoutBase>& node) {
+    auto& nodes = *static_cast<std::vector<std::shared_ptr<T>>*>(slots);
+    nodes[index] = std::static_pointer_cast<T>(node);
+  }
+
+  template <typename T>
+  static void AppendElement(void* slots, size_t index,
+                            const std::shared_ptr<LayoutBase>& node) {
+    auto& nodes = *static_cast<std::vector<std::shared_ptr<T>>*>(slots);
+    nodes.emplace_back(std::static_pointer_cast<T>(node));
+  }
+
+  const char* RecordReference(const char* id, std::shared_ptr<void> slot,
+                              size_t index, AssignFunc assign);
+
+  // Requires |ids_mutex_|.
+  uint32_t InternHandle(std::string_view id);
+
+  Expression expression_;
+  Dependencies dependencies_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<void>> fragments_;
+  std::unordered_multimap<uint64_t, std::shared_ptr<LayoutBlob>> blobs_;
+  size_t saved_blob_bytes_ = 0;
+
+  std::mutex ids_mutex_;
+  std::deque<std::string> ids_;
+  std::unordered_map<std::string_view, uint32_t> handles_;
+  std::vector<std::shared_ptr<LayoutBase>> nodes_;
+  std::vector<Reference> references_;
 };
 
+// Records a reference of the parse running on this thread.
+template <typename T>
+const char* AddReference(std::shared_ptr<void> owner,
+                         std::shared_ptr<T>* slot, const char* id) {
+  return ParseContext::GetCurrent()->AddReference(std::move(owner), slot, id);
+}
+
+template <typename T>
+const char* AddReference(std::shared_ptr<void> owner,
+                         std::vector<std::shared_ptr<T>>* slots,
+                         const char* id) {
+  return ParseContext::GetCurrent()->AddReference(std::move(owner), slots, id);
+}
+
+template <typename T>
+const char* AddReference(std::shared_ptr<void> owner,
+                         std::vector<std::shared_ptr<T>>* slots, size_t index,
+                         const char* id) {
+  return ParseContext::GetCurrent()->AddReference(std::move(owner), slots,
+                                                  index, id);
+}
+
+inline const char* InternId(const char* id) {
+  return ParseContext::GetCurrent()->InternId(id);
+}
+
+std::string GetLayoutCachePath(const std::string& cache_dir,
+                               const std::string& xml_path);
+std::shared_ptr<Layout> LoadCachedLayout(const std::string& cache_path);
+bool SaveCachedLayout(const std::string& cache_path,
+                      std::shared_ptr<Layout> layout,
+                      const std::vector<std::string>& dependencies);
+
 struct ParserStatus {
   std::shared_ptr<LayoutBase> parent;
   const tinyxml2::XMLElement* element = nullptr;
@@ -238,21 +496,53 @@ PipelineBindPoint StringToPipelineBindPoint(const char* value);
 IndexType StringToIndexType(const char* value);
 SubpassContents StringToSubpassContents(const char* value);
 DependencyFlags StringToDependencyFlags(const char* value);
-void StringToFloats(const char* value, std::vector<float>* results);
+bool StringToLiteral(std::string_view token, float* result);
+bool StringToLiteral(std::string_view token, int64_t* result);
+void StringToFloats(std::string_view value, std::vector<float>* results);
+bool AppendDataValues(std::string_view type, std::string_view text,
+                      std::vector<uint8_t>* data);
+bool AppendGeneratedValues(const tinyxml2::XMLElement* element,
+                           std::vector<uint8_t>* data);
+
+template <typename Func>
+static void ForEachToken(std::string_view value, Func func) {
+  const auto is_space = [](char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+           c == '\f';
+  };
+  size_t i = 0;
+
+  while (i < value.size()) {
+    while (i < value.size() && is_space(value[i])) ++i;
+    if (i == value.size()) break;
+
+    const size_t begin = i;
+    while (i < value.size() && !is_space(value[i])) ++i;
+    func(value.substr(begin, i - begin));
+  }
+}
 
 template <typename T>
-static void StringToIntegers(const char* value, std::vector<T>* results) {
-  std::stringstream ss(value);
-  std::string token;
-  size_t pos = -1;
-
-  while (ss >> token) {
-    while ((pos = token.rfind(',')) != std::string::npos) {
-      token.erase(pos, 1);
+static void StringToIntegers(std::string_view value,
+                             std::vector<T>* results) {
+  ForEachToken(value, [results](std::string_view token) {
+    std::string stripped;
+    if (token.find(',') != std::string_view::npos) {
+      stripped.reserve(token.size());
+      for (const char c : token) {
+        if (c != ',') stripped.push_back(c);
+      }
+      token = stripped;
     }
-    results->emplace_back(
-        static_cast<T>(Expression::Get().Evaluate(token.c_str())));
-  }
+
+    int64_t literal = 0;
+    if (StringToLiteral(token, &literal)) {
+      results->emplace_back(static_cast<T>(literal));
+    } else {
+      results->emplace_back(static_cast<T>(
+          Expression::Get().Evaluate(std::string(token).c_str())));
+    }
+  });
 }
 
 #ifdef XG_ENABLE_REALITY
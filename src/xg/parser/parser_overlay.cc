@@ -25,11 +25,15 @@ bool ParserSingleton<ParserOverlay>::ParseElement(
   auto node = std::make_shared<LayoutOverlay>();
   if (!node) return false;
 
-  node->lwin_id = element->Attribute("window");
-  node->lqueue_id = element->Attribute("queue");
-  node->ldesc_pool_id = element->Attribute("descriptorPool");
-  node->lswapchain_id = element->Attribute("swapchain");
-  node->lrender_pass_id = element->Attribute("renderPass");
+  node->lwin_id = AddReference(node, &node->lwin, element->Attribute("window"));
+  node->lqueue_id =
+      AddReference(node, &node->lqueue, element->Attribute("queue"));
+  node->ldesc_pool_id = AddReference(node, &node->ldesc_pool,
+                                     element->Attribute("descriptorPool"));
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
+  node->lrender_pass_id =
+      AddReference(node, &node->lrender_pass, element->Attribute("renderPass"));
 
   for (auto child = element->FirstChildElement(); child;
        child = child->NextSiblingElement()) {
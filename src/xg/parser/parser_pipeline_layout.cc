@@ -41,7 +41,10 @@ bool ParserSingleton<ParserPipelineLayout>::ParseElement(
 
     if (strcmp(name, "SetLayout") == 0) {
       const char* value = child->Attribute("descriptorSetLayout");
-      if (value) node->ldesc_set_layout_ids.emplace_back(value);
+      if (value) {
+        node->ldesc_set_layout_ids.emplace_back(
+            AddReference(node, &node->ldesc_set_layouts, value));
+      }
 
     } else if (strcmp(name, "PushConstantRange") == 0) {
       PushConstantRange range = {};
@@ -30,7 +30,8 @@ bool ParserSingleton<ParserPushConstants>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->llayout_id = element->Attribute("layout");
+  node->llayout_id =
+      AddReference(node, &node->llayout, element->Attribute("layout"));
 
   const char* value = element->Attribute("stageFlags");
   if (value) node->stage_flags = StringToShaderStageFlags(value);
@@ -41,7 +42,7 @@ bool ParserSingleton<ParserPushConstants>::ParseElement(
   value = element->Attribute("size");
   if (value) node->size = static_cast<int>(Expression::Get().Evaluate(value));
 
-  node->ldata_id = element->Attribute("data");
+  node->ldata_id = AddReference(node, &node->ldata, element->Attribute("data"));
 
   status->node = node;
 
@@ -28,7 +28,8 @@ bool ParserSingleton<ParserQueuePresent>::ParseElement(
     lwin_viewer->lqueue_present = node;
   }
 
-  node->lqueue_id = element->Attribute("queue");
+  node->lqueue_id =
+      AddReference(node, &node->lqueue, element->Attribute("queue"));
 
   for (auto child = element->FirstChildElement(); child;
        child = child->NextSiblingElement()) {
@@ -36,12 +37,18 @@ bool ParserSingleton<ParserQueuePresent>::ParseElement(
 
     if (strcmp(name, "WaitSemaphore") == 0) {
       const char* value = child->Attribute("semaphore");
-      if (value) node->lwait_semaphore_ids.emplace_back(value);
+      if (value) {
+        node->lwait_semaphore_ids.emplace_back(
+            AddReference(node, &node->lwait_semaphores, value));
+      }
     }
 
     if (strcmp(name, "Swapchain") == 0) {
       const char* value = child->Attribute("swapchain");
-      if (value) node->lswapchain_ids.emplace_back(value);
+      if (value) {
+        node->lswapchain_ids.emplace_back(
+            AddReference(node, &node->lswapchains, value));
+      }
     }
   }
 
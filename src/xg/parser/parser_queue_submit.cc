@@ -26,7 +26,8 @@ bool ParserSingleton<ParserQueueSubmit>::ParseElement(
     auto lwin_viewer = static_cast<LayoutWindowViewer*>(status->parent.get());
     const char* value = element->Attribute("queueSubmit");
     if (value) {
-      lwin_viewer->lqueue_submit_ids.emplace_back(value);
+      lwin_viewer->lqueue_submit_ids.emplace_back(
+          AddReference(status->parent, &lwin_viewer->lqueue_submits, value));
       return false;
     } else {
       lwin_viewer->lqueue_submits.emplace_back(node);
@@ -37,7 +38,8 @@ bool ParserSingleton<ParserQueueSubmit>::ParseElement(
     auto lview = static_cast<LayoutView*>(status->parent.get());
     const char* value = element->Attribute("queueSubmit");
     if (value) {
-      lview->lqueue_submit_ids.emplace_back(value);
+      lview->lqueue_submit_ids.emplace_back(
+          AddReference(status->parent, &lview->lqueue_submits, value));
       return false;
     } else {
       lview->lqueue_submits.emplace_back(node);
@@ -45,8 +47,10 @@ bool ParserSingleton<ParserQueueSubmit>::ParseElement(
   }
 #endif  // XG_ENABLE_REALITY
 
-  node->lqueue_id = element->Attribute("queue");
-  node->lfence_id = element->Attribute("fence");
+  node->lqueue_id =
+      AddReference(node, &node->lqueue, element->Attribute("queue"));
+  node->lfence_id =
+      AddReference(node, &node->lfence, element->Attribute("fence"));
 
   element->QueryBoolAttribute("enabled", &node->enabled);
 
@@ -28,7 +28,8 @@ bool ParserSingleton<ParserResetQueryPool>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->lquery_pool_id = element->Attribute("queryPool");
+  node->lquery_pool_id =
+      AddReference(node, &node->lquery_pool, element->Attribute("queryPool"));
   element->QueryIntAttribute("firstQuery", &node->first_query);
   element->QueryIntAttribute("queryCount", &node->query_count);
 
@@ -33,16 +33,28 @@ bool ParserSingleton<ParserResizer>::ParseElement(
 
     if (strcmp(name, "Image") == 0) {
       const char* value = child->Attribute("image");
-      if (value) node->limage_ids.emplace_back(value);
+      if (value) {
+        node->limage_ids.emplace_back(
+            AddReference(node, &node->limages, value));
+      }
     } else if (strcmp(name, "ImageView") == 0) {
       const char* value = child->Attribute("imageView");
-      if (value) node->limage_view_ids.emplace_back(value);
+      if (value) {
+        node->limage_view_ids.emplace_back(
+            AddReference(node, &node->limage_views, value));
+      }
     } else if (strcmp(name, "GraphicsPipeline") == 0) {
       const char* value = child->Attribute("graphicsPipeline");
-      if (value) node->lgraphics_pipeline_ids.emplace_back(value);
+      if (value) {
+        node->lgraphics_pipeline_ids.emplace_back(
+            AddReference(node, &node->lgraphics_pipelines, value));
+      }
     } else if (strcmp(name, "Framebuffer") == 0) {
       const char* value = child->Attribute("framebuffer");
-      if (value) node->lframebuffer_ids.emplace_back(value);
+      if (value) {
+        node->lframebuffer_ids.emplace_back(
+            AddReference(node, &node->lframebuffers, value));
+      }
     }
   }
 
@@ -28,7 +28,8 @@ bool ParserSingleton<ParserSetEvent>::ParseElement(
   auto lcmd_list = std::static_pointer_cast<LayoutCommandList>(status->parent);
   lcmd_list->lcmds.emplace_back(node);
 
-  node->levent_id = element->Attribute("event");
+  node->levent_id =
+      AddReference(node, &node->levent, element->Attribute("event"));
 
   const char* value = element->Attribute("stageMask");
   if (value) node->stage_mask = StringToPipelineStageFlags(value);
@@ -9,11 +9,12 @@
 #include "xg/parser/parser_internal.h"
 
 #include <memory>
+#include <utility>
 
 #include "tinyxml2.h"
 #include "xg/layout.h"
+#include "xg/mapped_file.h"
 #include "xg/types.h"
-#include "xg/utility.h"
 
 namespace xg {
 namespace parser {
@@ -31,7 +32,12 @@ bool ParserSingleton<ParserShaderModule>::ParseElement(
 
   const char* value = element->Attribute("file");
   if (value) {
-    if (!LoadFile(value, &node->code)) return false;
+    Dependencies::Get().Add(value);
+    auto mapped_file = MappedFile::Open(value);
+    if (!mapped_file) return false;
+
+    node->code = ParseContext::GetCurrent()->InternBlob(
+        std::make_shared<LayoutBlob>(std::move(mapped_file)));
   }
 
   status->node = node;
@@ -52,7 +52,7 @@ bool ParserSingleton<ParserSpecializationInfo>::ParseElement(
     }
   }
 
-  node->ldata_id = element->Attribute("data");
+  node->ldata_id = AddReference(node, &node->ldata, element->Attribute("data"));
 
   status->node = node;
 
@@ -39,7 +39,8 @@ bool ParserSingleton<ParserStage>::ParseElement(
   if (value) node->stage = StringToShaderStageFlags(value);
 
   value = element->Attribute("module");
-  if (value) node->lshader_module_id = value;
+  node->lshader_module_id =
+      AddReference(node, &node->lshader_module, value);
 
   value = element->Attribute("name");
   if (value) node->name = value;
@@ -33,7 +33,10 @@ bool ParserSingleton<ParserSubmit>::ParseElement(
 
     if (strcmp(name, "Wait") == 0) {
       const char* value = child->Attribute("semaphore");
-      if (value) node->lwait_semaphore_ids.emplace_back(value);
+      if (value) {
+        node->lwait_semaphore_ids.emplace_back(
+            AddReference(node, &node->lwait_semaphores, value));
+      }
 
       value = child->Attribute("dstStageMask");
       if (value) {
@@ -47,10 +50,16 @@ bool ParserSingleton<ParserSubmit>::ParseElement(
 
     } else if (strcmp(name, "CommandBuffer") == 0) {
       const char* value = child->Attribute("commandBuffer");
-      if (value) node->lcmd_buffer_ids.emplace_back(value);
+      if (value) {
+        node->lcmd_buffer_ids.emplace_back(
+            AddReference(node, &node->lcmd_buffers, value));
+      }
     } else if (strcmp(name, "SignalSemaphore") == 0) {
       const char* value = child->Attribute("semaphore");
-      if (value) node->lsignal_semaphore_ids.emplace_back(value);
+      if (value) {
+        node->lsignal_semaphore_ids.emplace_back(
+            AddReference(node, &node->lsignal_semaphores, value));
+      }
     }
   }
 
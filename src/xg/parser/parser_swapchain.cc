@@ -22,7 +22,7 @@ bool ParserSingleton<ParserSwapchain>::ParseElement(
   auto node = std::make_shared<LayoutSwapchain>();
   if (!node) return false;
 
-  node->lwin_id = element->Attribute("window");
+  node->lwin_id = AddReference(node, &node->lwin, element->Attribute("window"));
 
   element->QueryIntAttribute("minImageCount", &node->min_image_count);
 
@@ -39,7 +39,10 @@ bool ParserSingleton<ParserUpdater>::ParseElement(
 
     if (strcmp(name, "Buffer") == 0) {
       const char* value = child->Attribute("buffer");
-      if (value) node->lbuffer_ids.emplace_back(value);
+      if (value) {
+        node->lbuffer_ids.emplace_back(
+            AddReference(node, &node->lbuffers, value));
+      }
     }
   }
 
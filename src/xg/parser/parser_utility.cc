@@ -6,11 +6,21 @@
 // current version of the MIT License.
 // http://www.opensource.org/licenses/MIT
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 #include "glm/glm.hpp"
@@ -51,7 +61,7 @@ const char* Tinyxml2ErrorString(tinyxml2::XMLError error) {
 }
 
 Format StringToFormat(const char* format) {
-  static std::unordered_map<std::string, Format> mapping{
+  static constexpr auto mapping = MakeStringTable<Format>({
 #define ENTRY(s) {#s, Format::k##s}
       ENTRY(Undefined),
       ENTRY(R4G4UnormPack8),
@@ -273,7 +283,7 @@ Format StringToFormat(const char* format) {
       ENTRY(G16B16R162Plane422Unorm),
       ENTRY(G16B16R163Plane444Unorm)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(format);
   if (x != std::end(mapping)) {
     return x->second;
@@ -283,7 +293,7 @@ Format StringToFormat(const char* format) {
 }
 
 ColorSpace StringToColorSpace(const char* value) {
-  static std::unordered_map<std::string, ColorSpace> mapping{
+  static constexpr auto mapping = MakeStringTable<ColorSpace>({
 #define ENTRY(s) {#s, ColorSpace::k##s}
       ENTRY(SrgbNonlinear),
       ENTRY(DisplayP3Nonlinear),
@@ -302,7 +312,7 @@ ColorSpace StringToColorSpace(const char* value) {
       ENTRY(ExtendedSrgbNonlinear),
       ENTRY(DisplayNative)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -312,7 +322,7 @@ ColorSpace StringToColorSpace(const char* value) {
 }
 
 SurfaceTransformFlags StringToSurfaceTransformFlags(const char* value) {
-  static std::unordered_map<std::string, SurfaceTransformFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<SurfaceTransformFlags>({
 #define ENTRY(s) {#s, SurfaceTransformFlags::k##s}
       ENTRY(Identity),
       ENTRY(Rotate90),
@@ -324,7 +334,7 @@ SurfaceTransformFlags StringToSurfaceTransformFlags(const char* value) {
       ENTRY(HorizontalMirrorRotate270),
       ENTRY(Inherit)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -334,26 +344,24 @@ SurfaceTransformFlags StringToSurfaceTransformFlags(const char* value) {
 }
 
 CompositeAlpha StringToCompositeAlpha(const char* value) {
-  static std::unordered_map<std::string, CompositeAlpha> mapping{
+  static constexpr auto mapping = MakeStringTable<CompositeAlpha>({
 #define ENTRY(s) {#s, CompositeAlpha::k##s}
       ENTRY(Opaque), ENTRY(PreMultiplied), ENTRY(PostMultiplied), ENTRY(Inherit)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = CompositeAlpha::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 PresentMode StringToPresentMode(const char* value) {
-  static std::unordered_map<std::string, PresentMode> mapping{
+  static constexpr auto mapping = MakeStringTable<PresentMode>({
 #define ENTRY(s) {#s, PresentMode::k##s}
       ENTRY(Immediate),
       ENTRY(Mailbox),
@@ -362,7 +370,7 @@ PresentMode StringToPresentMode(const char* value) {
       ENTRY(SharedDemandRefresh),
       ENTRY(SharedContinuousRefresh)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -372,27 +380,25 @@ PresentMode StringToPresentMode(const char* value) {
 }
 
 QueueFamily StringToQueueFamily(const char* value) {
-  static std::unordered_map<std::string, QueueFamily> mapping{
+  static constexpr auto mapping = MakeStringTable<QueueFamily>({
 #define ENTRY(s) {#s, QueueFamily::k##s}
       ENTRY(Undefined),     ENTRY(Graphics), ENTRY(Compute), ENTRY(Transfer),
       ENTRY(SparseBinding), ENTRY(Protected)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = QueueFamily::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 BufferUsage StringToBufferUsage(const char* value) {
-  static std::unordered_map<std::string, BufferUsage> mapping{
+  static constexpr auto mapping = MakeStringTable<BufferUsage>({
 #define ENTRY(s) {#s, BufferUsage::k##s}
       ENTRY(Undefined),
       ENTRY(TransferSrc),
@@ -405,22 +411,20 @@ BufferUsage StringToBufferUsage(const char* value) {
       ENTRY(VertexBuffer),
       ENTRY(IndirectBuffer)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = BufferUsage::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 ImageCreateFlags StringToImageCreateFlags(const char* value) {
-  static std::unordered_map<std::string, ImageCreateFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageCreateFlags>({
 #define ENTRY(s) {#s, ImageCreateFlags::k##s}
       ENTRY(Undefined),
       ENTRY(SparseBinding),
@@ -439,26 +443,24 @@ ImageCreateFlags StringToImageCreateFlags(const char* value) {
       ENTRY(SampleLocationsCompatibleDepth),
       ENTRY(Subsampled)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = ImageCreateFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 ImageType StringToImageType(const char* value) {
-  static std::unordered_map<std::string, ImageType> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageType>({
 #define ENTRY(s) {#s, ImageType::k##s}
       ENTRY(1D), ENTRY(2D), ENTRY(3D)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -468,11 +470,11 @@ ImageType StringToImageType(const char* value) {
 }
 
 ImageTiling StringToImageTiling(const char* value) {
-  static std::unordered_map<std::string, ImageTiling> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageTiling>({
 #define ENTRY(s) {#s, ImageTiling::k##s}
       ENTRY(Optimal), ENTRY(Linear)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -482,7 +484,7 @@ ImageTiling StringToImageTiling(const char* value) {
 }
 
 ImageUsage StringToImageUsage(const char* value) {
-  static std::unordered_map<std::string, ImageUsage> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageUsage>({
 #define ENTRY(s) {#s, ImageUsage::k##s}
       ENTRY(TransferSrc),
       ENTRY(TransferDst),
@@ -493,22 +495,20 @@ ImageUsage StringToImageUsage(const char* value) {
       ENTRY(TransientAttachment),
       ENTRY(InputAttachment)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = ImageUsage::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 ImageLayout StringToImageLayout(const char* value) {
-  static std::unordered_map<std::string, ImageLayout> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageLayout>({
 #define ENTRY(s) {#s, ImageLayout::k##s}
       ENTRY(Undefined),
       ENTRY(General),
@@ -524,7 +524,7 @@ ImageLayout StringToImageLayout(const char* value) {
       ENTRY(PresentSrc),
       ENTRY(SharedPresent)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -534,7 +534,7 @@ ImageLayout StringToImageLayout(const char* value) {
 }
 
 MemoryAllocFlags StringToMemoryAllocFlags(const char* value) {
-  static std::unordered_map<std::string, MemoryAllocFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<MemoryAllocFlags>({
 #define ENTRY(s) {#s, MemoryAllocFlags::k##s}
       ENTRY(Undefined),
       ENTRY(DedicatedMemory),
@@ -543,27 +543,25 @@ MemoryAllocFlags StringToMemoryAllocFlags(const char* value) {
       ENTRY(CanBecomeLost),
       ENTRY(CanMakeOtherLost)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = MemoryAllocFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 MemoryUsage StringToMemoryUsage(const char* value) {
-  static std::unordered_map<std::string, MemoryUsage> mapping{
+  static constexpr auto mapping = MakeStringTable<MemoryUsage>({
 #define ENTRY(s) {#s, MemoryUsage::k##s}
       ENTRY(Unknown), ENTRY(GpuOnly), ENTRY(CpuOnly), ENTRY(CpuToGpu),
       ENTRY(GpuToCpu)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -573,12 +571,12 @@ MemoryUsage StringToMemoryUsage(const char* value) {
 }
 
 ImageViewType StringToImageViewType(const char* value) {
-  static std::unordered_map<std::string, ImageViewType> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageViewType>({
 #define ENTRY(s) {#s, ImageViewType::k##s}
       ENTRY(1D),      ENTRY(2D),      ENTRY(3D),       ENTRY(Cube),
       ENTRY(1DArray), ENTRY(2DArray), ENTRY(CubeArray)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -588,47 +586,33 @@ ImageViewType StringToImageViewType(const char* value) {
 }
 
 ComponentMapping StringToComponentMapping(const char* value) {
-  static std::unordered_map<std::string, ComponentSwizzle> mapping{
+  static constexpr auto mapping = MakeStringTable<ComponentSwizzle>({
 #define ENTRY(s) {#s, ComponentSwizzle::k##s}
       ENTRY(Identity), ENTRY(Zero), ENTRY(One), ENTRY(R),
       ENTRY(G),        ENTRY(B),    ENTRY(A)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   ComponentMapping result = {
       ComponentSwizzle::kIdentity, ComponentSwizzle::kIdentity,
       ComponentSwizzle::kIdentity, ComponentSwizzle::kIdentity};
+  ComponentSwizzle* components[] = {&result.r, &result.g, &result.b,
+                                    &result.a};
+  size_t i = 0;
 
-  if (ss >> token) {
-    const auto x = mapping.find(token.c_str());
-    if (x != std::end(mapping)) {
-      result.r = x->second;
-    }
-  }
-  if (ss >> token) {
-    const auto x = mapping.find(token.c_str());
-    if (x != std::end(mapping)) {
-      result.g = x->second;
-    }
-  }
-  if (ss >> token) {
-    const auto x = mapping.find(token.c_str());
-    if (x != std::end(mapping)) {
-      result.b = x->second;
-    }
-  }
-  if (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&components, &i](std::string_view token) {
+    if (i == std::size(components)) return;
+
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
-      result.a = x->second;
+      *components[i] = x->second;
     }
-  }
+    ++i;
+  });
   return result;
 }
 
 ImageAspectFlags StringToImageAspectFlags(const char* value) {
-  static std::unordered_map<std::string, ImageAspectFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<ImageAspectFlags>({
 #define ENTRY(s) {#s, ImageAspectFlags::k##s}
       ENTRY(Undefined),
       ENTRY(Color),
@@ -643,27 +627,25 @@ ImageAspectFlags StringToImageAspectFlags(const char* value) {
       ENTRY(MemoryPlane2),
       ENTRY(MemoryPlane3)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = ImageAspectFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 SamplerAddressMode StringToSamplerAddressMode(const char* value) {
-  static std::unordered_map<std::string, SamplerAddressMode> mapping{
+  static constexpr auto mapping = MakeStringTable<SamplerAddressMode>({
 #define ENTRY(s) {#s, SamplerAddressMode::k##s}
       ENTRY(Repeat), ENTRY(MirroredRepeat), ENTRY(ClampToEdge),
       ENTRY(ClampToBorder), ENTRY(MirrorClampToEdge)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -673,31 +655,29 @@ SamplerAddressMode StringToSamplerAddressMode(const char* value) {
 }
 
 SampleCountFlags StringToSampleCountFlags(const char* value) {
-  static std::unordered_map<std::string, SampleCountFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<SampleCountFlags>({
 #define ENTRY(s) {#s, SampleCountFlags::k##s}
       ENTRY(1),  ENTRY(2),  ENTRY(4), ENTRY(8),
       ENTRY(16), ENTRY(32), ENTRY(64)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = SampleCountFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 AttachmentLoadOp StringToAttachmentLoadOp(const char* value) {
-  static std::unordered_map<std::string, AttachmentLoadOp> mapping{
+  static constexpr auto mapping = MakeStringTable<AttachmentLoadOp>({
 #define ENTRY(s) {#s, AttachmentLoadOp::k##s}
       ENTRY(Load), ENTRY(Clear), ENTRY(DontCare)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -707,11 +687,11 @@ AttachmentLoadOp StringToAttachmentLoadOp(const char* value) {
 }
 
 AttachmentStoreOp StringToAttachmentStoreOp(const char* value) {
-  static std::unordered_map<std::string, AttachmentStoreOp> mapping{
+  static constexpr auto mapping = MakeStringTable<AttachmentStoreOp>({
 #define ENTRY(s) {#s, AttachmentStoreOp::k##s}
       ENTRY(Store), ENTRY(DontCare)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -721,7 +701,7 @@ AttachmentStoreOp StringToAttachmentStoreOp(const char* value) {
 }
 
 PipelineStageFlags StringToPipelineStageFlags(const char* value) {
-  static std::unordered_map<std::string, PipelineStageFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<PipelineStageFlags>({
 #define ENTRY(s) {#s, PipelineStageFlags::k##s}
       ENTRY(TopOfPipe),
       ENTRY(DrawIndirect),
@@ -741,22 +721,20 @@ PipelineStageFlags StringToPipelineStageFlags(const char* value) {
       ENTRY(AllGraphics),
       ENTRY(AllCommands)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = PipelineStageFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 AccessFlags StringToAccessFlags(const char* value) {
-  static std::unordered_map<std::string, AccessFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<AccessFlags>({
 #define ENTRY(s) {#s, AccessFlags::k##s}
       ENTRY(IndirectCommandRead),
       ENTRY(IndexRead),
@@ -776,22 +754,20 @@ AccessFlags StringToAccessFlags(const char* value) {
       ENTRY(MemoryRead),
       ENTRY(MemoryWrite)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = AccessFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 DescriptorType StringToDescriptorType(const char* value) {
-  static std::unordered_map<std::string, DescriptorType> mapping{
+  static constexpr auto mapping = MakeStringTable<DescriptorType>({
 #define ENTRY(s) {#s, DescriptorType::k##s}
       ENTRY(Sampler),
       ENTRY(CombinedImageSampler),
@@ -805,7 +781,7 @@ DescriptorType StringToDescriptorType(const char* value) {
       ENTRY(StorageBufferDynamic),
       ENTRY(InputAttachment)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -815,7 +791,7 @@ DescriptorType StringToDescriptorType(const char* value) {
 }
 
 ShaderStageFlags StringToShaderStageFlags(const char* value) {
-  static std::unordered_map<std::string, ShaderStageFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<ShaderStageFlags>({
 #define ENTRY(s) {#s, ShaderStageFlags::k##s}
       ENTRY(Vertex),
       ENTRY(TessellationControl),
@@ -826,26 +802,24 @@ ShaderStageFlags StringToShaderStageFlags(const char* value) {
       ENTRY(AllGraphics),
       ENTRY(All)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = ShaderStageFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 VertexInputRate StringToVertexInputRate(const char* value) {
-  static std::unordered_map<std::string, VertexInputRate> mapping{
+  static constexpr auto mapping = MakeStringTable<VertexInputRate>({
 #define ENTRY(s) {#s, VertexInputRate::k##s}
       ENTRY(Vertex), ENTRY(Instance)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -855,7 +829,7 @@ VertexInputRate StringToVertexInputRate(const char* value) {
 }
 
 PrimitiveTopology StringToPrimitiveTopology(const char* value) {
-  static std::unordered_map<std::string, PrimitiveTopology> mapping{
+  static constexpr auto mapping = MakeStringTable<PrimitiveTopology>({
 #define ENTRY(s) {#s, PrimitiveTopology::k##s}
       ENTRY(PointList),
       ENTRY(LineList),
@@ -869,7 +843,7 @@ PrimitiveTopology StringToPrimitiveTopology(const char* value) {
       ENTRY(TriangleStripWithAdjacency),
       ENTRY(PatchList)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -879,11 +853,11 @@ PrimitiveTopology StringToPrimitiveTopology(const char* value) {
 }
 
 PolygonMode StringToPolygonMode(const char* value) {
-  static std::unordered_map<std::string, PolygonMode> mapping{
+  static constexpr auto mapping = MakeStringTable<PolygonMode>({
 #define ENTRY(s) {#s, PolygonMode::k##s}
       ENTRY(Fill), ENTRY(Line), ENTRY(Point)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -893,30 +867,28 @@ PolygonMode StringToPolygonMode(const char* value) {
 }
 
 CullMode StringToCullMode(const char* value) {
-  static std::unordered_map<std::string, CullMode> mapping{
+  static constexpr auto mapping = MakeStringTable<CullMode>({
 #define ENTRY(s) {#s, CullMode::k##s}
       ENTRY(None), ENTRY(Front), ENTRY(Back), ENTRY(FrontAndBack)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = CullMode::kNone;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 FrontFace StringToFrontFace(const char* value) {
-  static std::unordered_map<std::string, FrontFace> mapping{
+  static constexpr auto mapping = MakeStringTable<FrontFace>({
 #define ENTRY(s) {#s, FrontFace::k##s}
       ENTRY(CounterClockwise), ENTRY(Clockwise)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -926,13 +898,13 @@ FrontFace StringToFrontFace(const char* value) {
 }
 
 CompareOp StringToCompareOp(const char* value) {
-  static std::unordered_map<std::string, CompareOp> mapping{
+  static constexpr auto mapping = MakeStringTable<CompareOp>({
 #define ENTRY(s) {#s, CompareOp::k##s}
       ENTRY(Never),          ENTRY(Less),    ENTRY(Equal),
       ENTRY(LessOrEqual),    ENTRY(Greater), ENTRY(NotEqual),
       ENTRY(GreaterOrEqual), ENTRY(Always)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -942,7 +914,7 @@ CompareOp StringToCompareOp(const char* value) {
 }
 
 BlendFactor StringToBlendFactor(const char* value) {
-  static std::unordered_map<std::string, BlendFactor> mapping{
+  static constexpr auto mapping = MakeStringTable<BlendFactor>({
 #define ENTRY(s) {#s, BlendFactor::k##s}
       ENTRY(Zero),
       ENTRY(One),
@@ -964,7 +936,7 @@ BlendFactor StringToBlendFactor(const char* value) {
       ENTRY(Src1Alpha),
       ENTRY(OneMinusSrc1Alpha)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -974,12 +946,12 @@ BlendFactor StringToBlendFactor(const char* value) {
 }
 
 BlendOp StringToBlendOp(const char* value) {
-  static std::unordered_map<std::string, BlendOp> mapping{
+  static constexpr auto mapping = MakeStringTable<BlendOp>({
 #define ENTRY(s) {#s, BlendOp::k##s}
       ENTRY(Add), ENTRY(Subtract), ENTRY(ReverseSubtract), ENTRY(Min),
       ENTRY(Max)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -989,26 +961,24 @@ BlendOp StringToBlendOp(const char* value) {
 }
 
 ColorComponent StringToColorComponent(const char* value) {
-  static std::unordered_map<std::string, ColorComponent> mapping{
+  static constexpr auto mapping = MakeStringTable<ColorComponent>({
 #define ENTRY(s) {#s, ColorComponent::k##s}
       ENTRY(R), ENTRY(G), ENTRY(B), ENTRY(A)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = ColorComponent::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 DynamicState StringToDynamicState(const char* value) {
-  static std::unordered_map<std::string, DynamicState> mapping{
+  static constexpr auto mapping = MakeStringTable<DynamicState>({
 #define ENTRY(s) {#s, DynamicState::k##s}
       ENTRY(Viewport),
       ENTRY(Scissor),
@@ -1019,7 +989,7 @@ DynamicState StringToDynamicState(const char* value) {
       ENTRY(StencilWriteMask),
       ENTRY(StencilReference)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1029,11 +999,11 @@ DynamicState StringToDynamicState(const char* value) {
 }
 
 Filter StringToFilter(const char* value) {
-  static std::unordered_map<std::string, Filter> mapping{
+  static constexpr auto mapping = MakeStringTable<Filter>({
 #define ENTRY(s) {#s, Filter::k##s}
       ENTRY(Nearest), ENTRY(Linear)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1043,11 +1013,11 @@ Filter StringToFilter(const char* value) {
 }
 
 SamplerMipmapMode StringToSamplerMipmapMode(const char* value) {
-  static std::unordered_map<std::string, SamplerMipmapMode> mapping{
+  static constexpr auto mapping = MakeStringTable<SamplerMipmapMode>({
 #define ENTRY(s) {#s, SamplerMipmapMode::k##s}
       ENTRY(Nearest), ENTRY(Linear)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1072,11 +1042,11 @@ glm::vec3 StringToVec3(const char* value) {
 }
 
 QueryType StringToQueryType(const char* value) {
-  static std::unordered_map<std::string, QueryType> mapping{
+  static constexpr auto mapping = MakeStringTable<QueryType>({
 #define ENTRY(s) {#s, QueryType::k##s}
       ENTRY(Occlusion), ENTRY(PipelineStatistics), ENTRY(Timestamp)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1101,11 +1071,11 @@ glm::vec4 StringToVec4(const char* value) {
 }
 
 PipelineBindPoint StringToPipelineBindPoint(const char* value) {
-  static std::unordered_map<std::string, PipelineBindPoint> mapping{
+  static constexpr auto mapping = MakeStringTable<PipelineBindPoint>({
 #define ENTRY(s) {#s, PipelineBindPoint::k##s}
       ENTRY(Graphics), ENTRY(Compute)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1115,11 +1085,11 @@ PipelineBindPoint StringToPipelineBindPoint(const char* value) {
 }
 
 IndexType StringToIndexType(const char* value) {
-  static std::unordered_map<std::string, IndexType> mapping{
+  static constexpr auto mapping = MakeStringTable<IndexType>({
 #define ENTRY(s) {#s, IndexType::k##s}
       ENTRY(Uint16), ENTRY(Uint32), ENTRY(None), ENTRY(Uint8)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1129,11 +1099,11 @@ IndexType StringToIndexType(const char* value) {
 }
 
 SubpassContents StringToSubpassContents(const char* value) {
-  static std::unordered_map<std::string, SubpassContents> mapping{
+  static constexpr auto mapping = MakeStringTable<SubpassContents>({
 #define ENTRY(s) {#s, SubpassContents::k##s}
       ENTRY(Inline), ENTRY(SecondaryCommandBuffers)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1143,41 +1113,71 @@ SubpassContents StringToSubpassContents(const char* value) {
 }
 
 DependencyFlags StringToDependencyFlags(const char* value) {
-  static std::unordered_map<std::string, DependencyFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<DependencyFlags>({
 #define ENTRY(s) {#s, DependencyFlags::k##s}
       ENTRY(Undefined), ENTRY(ByRegion), ENTRY(DeviceGroup), ENTRY(ViewLocal)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = DependencyFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
-void StringToFloats(const char* value, std::vector<float>* results) {
-  std::stringstream ss(value);
-  std::string token;
+// Not std::from_chars, which has no floating point overloads in the libc++
+// of the NDK and in libstdc++ before GCC 11.
+bool StringToLiteral(std::string_view token, float* result) {
+  char buffer[64];
+  if (token.empty() || token.size() >= sizeof(buffer) ||
+      std::isspace(static_cast<unsigned char>(token.front())))
+    return false;
 
-  while (ss >> token) {
-    if (value) results->emplace_back(Expression::Get().Evaluate(token.c_str()));
-  }
+  std::memcpy(buffer, token.data(), token.size());
+  buffer[token.size()] = '\0';
+
+  char* end = nullptr;
+  errno = 0;
+  const auto value = std::strtof(buffer, &end);
+  if (end != buffer + token.size() || errno == ERANGE) return false;
+
+  *result = value;
+  return true;
+}
+
+bool StringToLiteral(std::string_view token, int64_t* result) {
+  const char* first = token.data();
+  const char* last = first + token.size();
+  if (first != last && *first == '+') ++first;
+
+  const auto [ptr, ec] = std::from_chars(first, last, *result);
+  return ec == std::errc() && ptr == last;
+}
+
+void StringToFloats(std::string_view value, std::vector<float>* results) {
+  ForEachToken(value, [results](std::string_view token) {
+    float literal = 0.0f;
+    if (StringToLiteral(token, &literal)) {
+      results->emplace_back(literal);
+    } else {
+      results->emplace_back(
+          Expression::Get().Evaluate(std::string(token).c_str()));
+    }
+  });
 }
 
 #ifdef XG_ENABLE_REALITY
 
 FormFactor StringToFormFactor(const char* value) {
-  static std::unordered_map<std::string, FormFactor> mapping{
+  static constexpr auto mapping = MakeStringTable<FormFactor>({
 #define ENTRY(s) {#s, FormFactor::k##s}
       ENTRY(HeadMountedDisplay), ENTRY(HandheldDisplay)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1187,11 +1187,11 @@ FormFactor StringToFormFactor(const char* value) {
 }
 
 ReferenceSpaceType StringToReferenceSpaceType(const char* value) {
-  static std::unordered_map<std::string, ReferenceSpaceType> mapping{
+  static constexpr auto mapping = MakeStringTable<ReferenceSpaceType>({
 #define ENTRY(s) {#s, ReferenceSpaceType::k##s}
       ENTRY(View), ENTRY(Local), ENTRY(Stage)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1216,11 +1216,11 @@ glm::quat StringToQuaternion(const char* value) {
 }
 
 ViewConfigurationType StringToViewConfigurationType(const char* value) {
-  static std::unordered_map<std::string, ViewConfigurationType> mapping{
+  static constexpr auto mapping = MakeStringTable<ViewConfigurationType>({
 #define ENTRY(s) {#s, ViewConfigurationType::k##s}
       ENTRY(PrimaryMono), ENTRY(PrimaryStereo)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -1230,7 +1230,7 @@ ViewConfigurationType StringToViewConfigurationType(const char* value) {
 }
 
 SwapchainUsage StringToSwapchainUsage(const char* value) {
-  static std::unordered_map<std::string, SwapchainUsage> mapping{
+  static constexpr auto mapping = MakeStringTable<SwapchainUsage>({
 #define ENTRY(s) {#s, SwapchainUsage::k##s}
       ENTRY(ColorAttachment),
       ENTRY(DepthStencilAttachment),
@@ -1241,46 +1241,42 @@ SwapchainUsage StringToSwapchainUsage(const char* value) {
       ENTRY(MutableFormat),
       ENTRY(InputAttachmentBit)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = SwapchainUsage::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 CompositionLayerFlags StringToCompositionLayerFlags(const char* value) {
-  static std::unordered_map<std::string, CompositionLayerFlags> mapping{
+  static constexpr auto mapping = MakeStringTable<CompositionLayerFlags>({
 #define ENTRY(s) {#s, CompositionLayerFlags::k##s}
       ENTRY(CorrectChromaticAberration), ENTRY(BlendTextureSourceAlpha),
       ENTRY(UnpremultipliedAlpha)
 #undef ENTRY
-  };
-  std::stringstream ss(value);
-  std::string token;
+  });
   auto result = CompositionLayerFlags::kUndefined;
 
-  while (ss >> token) {
-    const auto x = mapping.find(token.c_str());
+  ForEachToken(value, [&result](std::string_view token) {
+    const auto x = mapping.find(token);
     if (x != std::end(mapping)) {
       result = result | x->second;
     }
-  }
+  });
   return result;
 }
 
 EnvironmentBlendMode StringToEnvironmentBlendMode(const char* value) {
-  static std::unordered_map<std::string, EnvironmentBlendMode> mapping{
+  static constexpr auto mapping = MakeStringTable<EnvironmentBlendMode>({
 #define ENTRY(s) {#s, EnvironmentBlendMode::k##s}
       ENTRY(Opaque), ENTRY(Additive), ENTRY(AlphaBlend)
 #undef ENTRY
-  };
+  });
   const auto x = mapping.find(value);
   if (x != std::end(mapping)) {
     return x->second;
@@ -28,7 +28,8 @@ bool ParserSingleton<ParserViewportState>::ParseElement(
       static_cast<LayoutGraphicsPipeline*>(status->parent.get());
   lgraphics_pipeline->lviewport_state = node;
 
-  node->lswapchain_id = element->Attribute("swapchain");
+  node->lswapchain_id =
+      AddReference(node, &node->lswapchain, element->Attribute("swapchain"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
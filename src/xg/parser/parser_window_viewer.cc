@@ -24,10 +24,13 @@ bool ParserSingleton<ParserWindowViewer>::ParseElement(
   auto node = std::make_shared<LayoutWindowViewer>();
   if (!node) return false;
 
-  node->lwin_id = element->Attribute("window");
-  node->lframe_id = element->Attribute("frame");
-  node->lcamera_id = element->Attribute("camera");
-  node->loverlay_id = element->Attribute("overlay");
+  node->lwin_id = AddReference(node, &node->lwin, element->Attribute("window"));
+  node->lframe_id =
+      AddReference(node, &node->lframe, element->Attribute("frame"));
+  node->lcamera_id =
+      AddReference(node, &node->lcamera, element->Attribute("camera"));
+  node->loverlay_id =
+      AddReference(node, &node->loverlay, element->Attribute("overlay"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
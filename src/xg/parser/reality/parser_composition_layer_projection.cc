@@ -25,7 +25,8 @@ bool ParserSingleton<ParserCompositionLayerProjection>::ParseElement(
   const char* value = element->Attribute("layerFlags");
   if (value) node->layer_flags = StringToCompositionLayerFlags(value);
 
-  node->lspace_id = element->Attribute("space");
+  node->lspace_id =
+      AddReference(node, &node->lspace, element->Attribute("space"));
 
   for (auto child = element->FirstChildElement(); child;
        child = child->NextSiblingElement()) {
@@ -40,6 +41,11 @@ bool ParserSingleton<ParserCompositionLayerProjection>::ParseElement(
     }
   }
 
+  for (auto& lview : node->lviews) {
+    lview.lswapchain_id =
+        AddReference(node, &lview.lswapchain, lview.lswapchain_id);
+  }
+
   status->node = node;
 
   return ParserBase::Get().ParseElement(element, status);
@@ -37,7 +37,8 @@ bool ParserSingleton<ParserEndFrame>::ParseElement(
 
     if (strcmp(name, "Layer") == 0) {
       auto llayer_id = child->Attribute("layer");
-      node->llayer_ids.emplace_back(llayer_id);
+      node->llayer_ids.emplace_back(
+          AddReference(node, &node->llayers, llayer_id));
     }
   }
 
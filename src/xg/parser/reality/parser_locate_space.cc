@@ -34,7 +34,8 @@ bool ParserSingleton<ParserLocateSpace>::ParseElement(
 
     if (strcmp(name, "Space") == 0) {
       auto lspace_id = child->Attribute("space");
-      node->lspace_ids.emplace_back(lspace_id);
+      node->lspace_ids.emplace_back(
+          AddReference(node, &node->lspaces, lspace_id));
     }
   }
 
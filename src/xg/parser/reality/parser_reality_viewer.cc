@@ -28,7 +28,8 @@ bool ParserSingleton<ParserRealityViewer>::ParseElement(
   const char* value = element->Attribute("viewConfigurationType");
   if (value) node->view_config_type = StringToViewConfigurationType(value);
 
-  node->lspace_id = element->Attribute("space");
+  node->lspace_id =
+      AddReference(node, &node->lspace, element->Attribute("space"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
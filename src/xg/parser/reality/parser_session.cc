@@ -23,7 +23,8 @@ bool ParserSingleton<ParserSession>::ParseElement(
   auto node = std::make_shared<LayoutSession>();
   if (!node) return false;
 
-  node->lqueue_id = element->Attribute("queue");
+  node->lqueue_id =
+      AddReference(node, &node->lqueue, element->Attribute("queue"));
 
   status->node = node;
 
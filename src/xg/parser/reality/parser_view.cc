@@ -27,8 +27,10 @@ bool ParserSingleton<ParserView>::ParseElement(
     lreality_viewer->lviews.emplace_back(node);
   }
 
-  node->lframe_id = element->Attribute("frame");
-  node->lcamera_id = element->Attribute("camera");
+  node->lframe_id =
+      AddReference(node, &node->lframe, element->Attribute("frame"));
+  node->lcamera_id =
+      AddReference(node, &node->lcamera, element->Attribute("camera"));
 
   status->node = node;
   status->child_element = element->FirstChildElement();
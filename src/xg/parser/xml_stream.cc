@@ -0,0 +1,171 @@
+// xg - XML Graphics Device
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include "xg/parser/xml_stream.h"
+
+#include <cstddef>
+#include <string_view>
+
+#include "xg/logger.h"
+
+namespace xg {
+namespace parser {
+
+static bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Returns the position of the '>' closing the tag at |pos|, skipping quoted
+// attribute values.
+static size_t FindTagEnd(std::string_view xml, size_t pos) {
+  char quote = '\0';
+
+  for (auto i = pos + 1; i < xml.size(); ++i) {
+    const char c = xml[i];
+    if (quote) {
+      if (c == quote) quote = '\0';
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '>') {
+      return i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+bool XmlStream::ReadRoot(Element* root) {
+  if (!SkipMisc() || !ReadStartTag(root)) {
+    if (!error_) XG_ERROR("no root element");
+    error_ = true;
+    return false;
+  }
+
+  root->content = std::string_view();
+  root->text = root->start_tag;
+  done_ = root->empty;
+
+  return true;
+}
+
+bool XmlStream::ReadElement(Element* element) {
+  if (done_ || error_) return false;
+  if (!SkipMisc()) return false;
+
+  const auto begin = pos_;
+  if (!ReadStartTag(element)) return false;
+
+  if (element->empty) {
+    element->content = std::string_view();
+  } else if (!ReadContent(element)) {
+    return false;
+  }
+  element->text = xml_.substr(begin, pos_ - begin);
+
+  return true;
+}
+
+bool XmlStream::SkipMisc() {
+  while (true) {
+    pos_ = xml_.find('<', pos_);
+    if (pos_ == std::string_view::npos) {
+      pos_ = xml_.size();
+      done_ = true;
+      return false;
+    }
+
+    if (SkipSpecial()) continue;
+    if (error_) return false;
+
+    if (IsAt("</")) {
+      done_ = true;
+      return false;
+    }
+    return true;
+  }
+}
+
+bool XmlStream::SkipSpecial() {
+  if (IsAt("<!--")) return SkipPast("-->");
+  if (IsAt("<![CDATA[")) return SkipPast("]]>");
+  if (IsAt("<?")) return SkipPast("?>");
+  if (IsAt("<!")) return SkipPast(">");
+  return false;
+}
+
+bool XmlStream::SkipPast(std::string_view terminator) {
+  const auto pos = xml_.find(terminator, pos_ + 2);
+  if (pos == std::string_view::npos) {
+    XG_ERROR("unterminated markup at offset {}", pos_);
+    error_ = true;
+    return false;
+  }
+  pos_ = pos + terminator.size();
+  return true;
+}
+
+bool XmlStream::ReadStartTag(Element* element) {
+  const auto begin = pos_;
+  auto i = begin + 1;
+  while (i < xml_.size() && !IsSpace(xml_[i]) && xml_[i] != '/' &&
+         xml_[i] != '>') {
+    ++i;
+  }
+  element->name = xml_.substr(begin + 1, i - begin - 1);
+
+  const auto end = FindTagEnd(xml_, begin);
+  if (element->name.empty() || end == std::string_view::npos) {
+    XG_ERROR("invalid start tag at offset {}", begin);
+    error_ = true;
+    return false;
+  }
+
+  element->empty = xml_[end - 1] == '/';
+  element->start_tag = xml_.substr(begin, end + 1 - begin);
+  pos_ = end + 1;
+
+  return true;
+}
+
+bool XmlStream::ReadContent(Element* element) {
+  const auto begin = pos_;
+  int depth = 1;
+
+  while (true) {
+    pos_ = xml_.find('<', pos_);
+    if (pos_ == std::string_view::npos) {
+      XG_ERROR("unterminated element: {}", element->name);
+      pos_ = xml_.size();
+      error_ = true;
+      return false;
+    }
+
+    if (SkipSpecial()) continue;
+    if (error_) return false;
+
+    const auto end = FindTagEnd(xml_, pos_);
+    if (end == std::string_view::npos) {
+      XG_ERROR("invalid tag at offset {}", pos_);
+      error_ = true;
+      return false;
+    }
+
+    if (IsAt("</")) {
+      if (--depth == 0) {
+        element->content = xml_.substr(begin, pos_ - begin);
+        pos_ = end + 1;
+        return true;
+      }
+    } else if (xml_[end - 1] != '/') {
+      ++depth;
+    }
+    pos_ = end + 1;
+  }
+}
+
+}  // namespace parser
+}  // namespace xg
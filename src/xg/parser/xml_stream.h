@@ -0,0 +1,62 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#ifndef XG_PARSER_XML_STREAM_H_
+#define XG_PARSER_XML_STREAM_H_
+
+#include <cstddef>
+#include <string_view>
+
+namespace xg {
+namespace parser {
+
+// Splits xml text into sibling elements without building a DOM. Markup is
+// only scanned for element boundaries; it is not validated.
+class XmlStream {
+ public:
+  struct Element {
+    std::string_view name;
+    std::string_view start_tag;
+    std::string_view content;
+    std::string_view text;
+    bool empty = false;
+  };
+
+  explicit XmlStream(std::string_view xml) : xml_(xml) {}
+
+  // Reads the start tag of the root element, after which ReadElement()
+  // returns the children of the root.
+  bool ReadRoot(Element* root);
+
+  // Reads the next sibling element. Returns false at the end of the parent
+  // element or of the text, or on error.
+  bool ReadElement(Element* element);
+
+  bool IsError() const { return error_; }
+  size_t GetOffset() const { return pos_; }
+
+ private:
+  bool IsAt(std::string_view markup) const {
+    return xml_.compare(pos_, markup.size(), markup) == 0;
+  }
+  bool SkipMisc();
+  bool SkipSpecial();
+  bool SkipPast(std::string_view terminator);
+  bool ReadStartTag(Element* element);
+  bool ReadContent(Element* element);
+
+  std::string_view xml_;
+  size_t pos_ = 0;
+  bool done_ = false;
+  bool error_ = false;
+};
+
+}  // namespace parser
+}  // namespace xg
+
+#endif  // XG_PARSER_XML_STREAM_H_
@@ -312,7 +312,7 @@ std::shared_ptr<CommandList> Renderer::CreateCommandList(
           return nullptr;
         }
         auto lfunction = std::static_pointer_cast<LayoutFunction>(lcmd);
-        cmd->Init(lfunction.get());
+        if (!cmd->Init(lfunction.get())) return nullptr;
 
         cmd_list->commands_.emplace_back(cmd);
         lcmd->instance = std::move(cmd);
@@ -558,7 +558,7 @@ std::shared_ptr<CommandList> Renderer::CreateCommandList(
         }
         auto lpush_constants =
             std::static_pointer_cast<LayoutPushConstants>(lcmd);
-        cmd->Init(lpush_constants.get());
+        if (!cmd->Init(lpush_constants.get())) return nullptr;
 
         cmd_list->commands_.emplace_back(cmd);
         lcmd->instance = std::move(cmd);
@@ -135,6 +135,8 @@ void ResourceLoader::Finish() {
   context_->loader.reset();
   context_ = nullptr;
   status_ = ResourceLoaderStatus::kFinished;
+
+  OnFinished();
 }
 
 }  // namespace xg
@@ -66,6 +66,9 @@ class ResourceLoader : public Task {
   int GetResult() const { return result_; }
 
  protected:
+  // Called once, by the Finish that finishes the loader, under |mutex_|.
+  virtual void OnFinished() {}
+
   ResourceLoaderContext* context_ = nullptr;
   ResourceLoaderStatus status_ = ResourceLoaderStatus::kUndefined;
   int result_ = -1;
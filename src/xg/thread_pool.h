@@ -68,6 +68,8 @@ class ThreadPool {
 
   size_t GetWorkerCount() { return worker_count_; }
 
+  bool IsWorkerThread() { return GetCurrentWorkerId() < worker_count_; }
+
   template <typename Task>
   void Post(Task&& task) {
     thread_pool_->post(std::forward<Task>(task));
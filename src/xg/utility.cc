@@ -11,6 +11,7 @@
 #include <cassert>
 
 #include "SDL.h"
+#include "xg/asset_pack.h"
 #include "xg/logger.h"
 
 namespace xg {
@@ -226,6 +227,13 @@ int FormatToSize(Format format) {
 bool LoadFile(const std::string& filepath, std::vector<uint8_t>* data) {
   assert(!filepath.empty());
   assert(data);
+
+  const auto file = AssetPackRegistry::Get().Find(filepath);
+  if (file) {
+    data->assign(file->GetData(), file->GetData() + file->GetSize());
+    return true;
+  }
+
   XG_DEBUG("load file: {}", filepath);
 
   auto* rw = SDL_RWFromFile(filepath.c_str(), "rb");
@@ -263,16 +271,31 @@ bool SaveFile(const std::string& filepath, const std::vector<uint8_t>& data) {
 
   auto size_write = SDL_RWwrite(rw, data.data(), 1, data.size());
   if (size_write != data.size()) {
-    XG_ERROR("write file size incorrect: {} != {}", size_write);
+    XG_ERROR("write file size incorrect: {} != {}", size_write, data.size());
     SDL_RWclose(rw);
     return false;
   }
 
-  SDL_RWclose(rw);
+  // buffered writes that fail, such as on a full disk, fail the close
+  if (SDL_RWclose(rw) != 0) {
+    XG_ERROR("failed to write file: {}, error: {}", filepath, SDL_GetError());
+    return false;
+  }
 
   return true;
 }
 
+uint64_t HashData(const void* data, size_t size, uint64_t seed) {
+  // 64-bit FNV-1a
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
 #ifdef XG_ENABLE_REALITY
 const char* RealityResultString(Result result) {
   switch (result) {
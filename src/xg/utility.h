@@ -22,6 +22,8 @@ const char* ResultString(Result result);
 int FormatToSize(Format format);
 bool LoadFile(const std::string& filepath, std::vector<uint8_t>* data);
 bool SaveFile(const std::string& filepath, const std::vector<uint8_t>& data);
+uint64_t HashData(const void* data, size_t size,
+                  uint64_t seed = 0xcbf29ce484222325ull);
 
 #ifdef XG_ENABLE_REALITY
 const char* RealityResultString(Result result);
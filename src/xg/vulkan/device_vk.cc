@@ -9,12 +9,17 @@
 #include "xg/vulkan/device_vk.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -25,7 +30,9 @@
 #include "vulkan/vulkan.hpp"
 #include "xg/layout.h"
 #include "xg/logger.h"
+#include "xg/mapped_file.h"
 #include "xg/renderer.h"
+#include "xg/thread_pool.h"
 #include "xg/types.h"
 #include "xg/utility.h"
 #include "xg/vulkan/buffer_vk.h"
@@ -627,10 +634,14 @@ std::shared_ptr<ShaderModule> DeviceVK::CreateShaderModule(
     XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
     return nullptr;
   }
-  const auto& create_info = vk::ShaderModuleCreateInfo()
-                                .setCodeSize(lshader_module.code.size())
-                                .setPCode(reinterpret_cast<const uint32_t*>(
-                                    lshader_module.code.data()));
+  assert(lshader_module.code);
+  const uint8_t* code = lshader_module.code->GetData();
+  const size_t code_size = lshader_module.code->GetSize();
+  if (!code && code_size != 0) return nullptr;
+
+  const auto& create_info =
+      vk::ShaderModuleCreateInfo().setCodeSize(code_size).setPCode(
+          reinterpret_cast<const uint32_t*>(code));
 
   const auto& result = device_.createShaderModule(
       &create_info, nullptr, &shader_module->shader_module_);
@@ -642,7 +653,7 @@ std::shared_ptr<ShaderModule> DeviceVK::CreateShaderModule(
 
   XG_TRACE("createShaderModule: {} {} {}",
            (void*)(VkShaderModule)shader_module->shader_module_,
-           lshader_module.id, lshader_module.code.size());
+           lshader_module.id, code_size);
 
   return shader_module;
 }
@@ -754,6 +765,106 @@ std::shared_ptr<PipelineLayout> DeviceVK::CreatePipelineLayout(
   return pipeline_layout;
 }
 
+// The batches of a pipeline creation, taken in turn by the calling thread
+// and the workers. The calling thread only waits for the batches that are
+// being compiled, so it makes progress even if every worker is busy.
+class PipelineBatches : public Task {
+ public:
+  using CreateFunc = std::function<vk::Result(size_t first, size_t count)>;
+
+  PipelineBatches(size_t pipeline_count, size_t batch_count, CreateFunc create)
+      : pipeline_count_(pipeline_count),
+        batch_count_(batch_count),
+        create_(std::move(create)),
+        results_(batch_count),
+        durations_(batch_count) {}
+
+  void Run(std::shared_ptr<Task> self) override {
+    for (;;) {
+      const auto batch = next_batch_.fetch_add(1);
+      if (batch >= batch_count_) break;
+
+      const auto first = GetFirst(batch);
+      const auto start = std::chrono::steady_clock::now();
+      results_[batch] = create_(first, GetFirst(batch + 1) - first);
+      durations_[batch] = std::chrono::steady_clock::now() - start;
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (++finished_count_ == batch_count_) finished_.notify_all();
+    }
+  }
+
+  vk::Result Wait(const char* name) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      finished_.wait(lock,
+                     [this] { return finished_count_ == batch_count_; });
+    }
+
+    auto result = vk::Result::eSuccess;
+    for (size_t i = 0; i < batch_count_; ++i) {
+      const auto count = GetFirst(i + 1) - GetFirst(i);
+      XG_DEBUG("{} batch {}/{}: {} pipelines, {:.3f} ms", name, i + 1,
+               batch_count_, count,
+               std::chrono::duration<double, std::milli>(durations_[i])
+                   .count());
+      if (results_[i] != vk::Result::eSuccess) result = results_[i];
+    }
+    return result;
+  }
+
+ private:
+  size_t GetFirst(size_t batch) const {
+    return pipeline_count_ * batch / batch_count_;
+  }
+
+  const size_t pipeline_count_;
+  const size_t batch_count_;
+  CreateFunc create_;
+  std::vector<vk::Result> results_;
+  std::vector<std::chrono::steady_clock::duration> durations_;
+  std::atomic<size_t> next_batch_{0};
+  size_t finished_count_ = 0;
+  std::condition_variable finished_;
+};
+
+// Splits the pipelines in batches, one per worker but not smaller than
+// kMinPipelinesPerBatch, and compiles them concurrently. The pipeline cache
+// of the device is shared, as its use is synchronized by the driver.
+static vk::Result CreatePipelinesInBatches(
+    const char* name, const vk::Device& device, size_t pipeline_count,
+    PipelineBatches::CreateFunc create,
+    std::vector<vk::Pipeline>* vk_pipelines) {
+  static constexpr size_t kMinPipelinesPerBatch = 4;
+  auto& thread_pool = ThreadPool::Get();
+
+  const auto batch_count = std::max<size_t>(
+      1, std::min(thread_pool.GetWorkerCount(),
+                  pipeline_count / kMinPipelinesPerBatch));
+  auto batches = std::make_shared<PipelineBatches>(pipeline_count,
+                                                   batch_count,
+                                                   std::move(create));
+  if (!batches) {
+    XG_ERROR(ResultString(Result::kErrorOutOfHostMemory));
+    return vk::Result::eErrorOutOfHostMemory;
+  }
+
+  for (size_t i = 1; i < batch_count; ++i) {
+    thread_pool.Post(ThreadPool::Job(batches));
+  }
+  batches->Run(batches);
+
+  const auto result = batches->Wait(name);
+  if (result != vk::Result::eSuccess) {
+    // the batches that did compile
+    for (auto& vk_pipeline : *vk_pipelines) {
+      if (vk_pipeline) device.destroyPipeline(vk_pipeline);
+      vk_pipeline = nullptr;
+    }
+  }
+  return result;
+}
+
 Result DeviceVK::InitComputePipelines(
     const std::vector<std::shared_ptr<LayoutComputePipeline>>&
         lcompute_pipelines,
@@ -844,9 +955,14 @@ Result DeviceVK::InitComputePipelines(
     create_infos.emplace_back(create_info);
   }
 
-  const auto& result = device_.createComputePipelines(
-      pipeline_cache_, static_cast<uint32_t>(create_infos.size()),
-      create_infos.data(), nullptr, vk_pipelines.data());
+  const auto& result = CreatePipelinesInBatches(
+      "createComputePipelines", device_, create_infos.size(),
+      [&](size_t first, size_t count) {
+        return device_.createComputePipelines(
+            pipeline_cache_, static_cast<uint32_t>(count),
+            create_infos.data() + first, nullptr, vk_pipelines.data() + first);
+      },
+      &vk_pipelines);
   if (result != vk::Result::eSuccess) {
     XG_ERROR(ResultString(static_cast<Result>(result)));
     return static_cast<Result>(result);
@@ -1344,9 +1460,14 @@ Result DeviceVK::InitGraphicsPipelines(
     create_infos.emplace_back(create_info);
   }
 
-  const auto& result = device_.createGraphicsPipelines(
-      pipeline_cache_, static_cast<uint32_t>(create_infos.size()),
-      create_infos.data(), nullptr, vk_pipelines.data());
+  const auto& result = CreatePipelinesInBatches(
+      "createGraphicsPipelines", device_, create_infos.size(),
+      [&](size_t first, size_t count) {
+        return device_.createGraphicsPipelines(
+            pipeline_cache_, static_cast<uint32_t>(count),
+            create_infos.data() + first, nullptr, vk_pipelines.data() + first);
+      },
+      &vk_pipelines);
   if (result != vk::Result::eSuccess) {
     XG_ERROR(ResultString(static_cast<Result>(result)));
     return static_cast<Result>(result);
@@ -298,12 +298,13 @@ bool RendererVK::CreateGraphicsPipelines(
 
         if (lspec_info->ldata) {
           auto& ldata = lspec_info->ldata;
-          lspec_info->data = ldata->data.data();
+          lspec_info->data = ldata->data->GetData();
+          if (!lspec_info->data && ldata->data->GetSize() != 0) return false;
 
-          if (lspec_info->data_size < ldata->data.size()) {
+          if (lspec_info->data_size < ldata->data->GetSize()) {
             XG_WARN("specialization data size {} < {}", lspec_info->data_size,
-                    ldata->data.size());
-            lspec_info->data_size = ldata->data.size();
+                    ldata->data->GetSize());
+            lspec_info->data_size = ldata->data->GetSize();
           }
         }
       }
@@ -371,12 +372,13 @@ bool RendererVK::CreateComputePipelines(
 
       if (lspec_info->ldata) {
         auto& ldata = lspec_info->ldata;
-        lspec_info->data = ldata->data.data();
+        lspec_info->data = ldata->data->GetData();
+        if (!lspec_info->data && ldata->data->GetSize() != 0) return false;
 
-        if (lspec_info->data_size < ldata->data.size()) {
+        if (lspec_info->data_size < ldata->data->GetSize()) {
           XG_WARN("specialization data size {} < {}", lspec_info->data_size,
-                  ldata->data.size());
-          lspec_info->data_size = ldata->data.size();
+                  ldata->data->GetSize());
+          lspec_info->data_size = ldata->data->GetSize();
         }
       }
     }
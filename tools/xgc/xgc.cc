@@ -0,0 +1,195 @@
+// xg - XML Graphics Engine
+// Copyright (c) Jim Tan
+//
+// Free use of the XML Graphics Engine is
+// permitted under the guidelines and in accordance with the most
+// current version of the MIT License.
+// http://www.opensource.org/licenses/MIT
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "xg/asset_pack.h"
+#include "xg/layout.h"
+#include "xg/mapped_file.h"
+#include "xg/parser.h"
+
+static void PrintUsage() {
+  std::cout << "usage: xgc [options] layout.xml\n"
+               "       xgc --pack FILE [--zstd] [--level N] files...\n"
+               "  -o FILE           compiled layout, layout.xgl by default\n"
+               "  --zstd            compress instead of writing in sections\n"
+               "  --level N         zstd compression level\n"
+               "  --depfile FILE    write the files the layout depends on\n"
+               "  --pack FILE       pack the files into an asset pack\n"
+               "the layout is parsed, and the files are packed under the\n"
+               "paths they are given by, from the current directory"
+            << std::endl;
+}
+
+// In make syntax, which is what CMake reads.
+static std::string EscapeDependency(const std::string& path) {
+  std::string escaped;
+  for (const char c : path) {
+    if (c == ' ' || c == '#') escaped += '\\';
+    if (c == '$') escaped += '$';
+    escaped += c;
+  }
+  return escaped;
+}
+
+// The paths are made absolute, as the build tool does not run in the
+// directory the layout is parsed in.
+static bool WriteDepfile(const std::string& depfile_path,
+                         const std::string& output_path,
+                         const std::vector<std::string>& dependencies) {
+  std::ofstream out(depfile_path, std::ios::binary);
+  out << EscapeDependency(output_path) << ":";
+  for (const auto& dependency : dependencies) {
+    const auto path = std::filesystem::absolute(dependency).generic_string();
+    out << " \\\n  " << EscapeDependency(path);
+  }
+  out << "\n";
+  return static_cast<bool>(out);
+}
+
+// Written and checked the same way as a layout.
+static int PackAssets(const std::string& pack_path,
+                      const std::vector<std::string>& files,
+                      const xg::AssetPackInfo& info) {
+  const auto temp_path = pack_path + ".tmp";
+  const auto fail = [&temp_path](const char* message,
+                                 const std::string& path) {
+    std::cerr << message << path << std::endl;
+    std::error_code error;
+    std::filesystem::remove(temp_path, error);
+    return EXIT_FAILURE;
+  };
+
+  if (!xg::AssetPack::Create(temp_path, files, info)) {
+    return fail("failed to write asset pack: ", pack_path);
+  }
+
+  size_t entry_count = 0;
+  {
+    // closed before it is renamed, which Windows requires
+    const auto pack = xg::AssetPack::Open(temp_path);
+    if (!pack) return fail("failed to load asset pack: ", pack_path);
+    for (const auto& file : files) {
+      if (!pack->Find(file)) return fail("failed to find asset: ", file);
+    }
+    entry_count = pack->GetEntryCount();
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, pack_path, error);
+  if (error) return fail("failed to replace asset pack: ", pack_path);
+
+  std::cout << pack_path << ": " << entry_count << " entries" << std::endl;
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  xg::LayoutSerializeInfo info;
+  info.sectioned = true;
+  xg::AssetPackInfo pack_info;
+  std::vector<std::string> input_paths;
+  std::string output_path;
+  std::string depfile_path;
+  std::string pack_path;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg(argv[i]);
+    const bool has_value = i + 1 < argc;
+
+    if (arg == "-o" && has_value) {
+      output_path = argv[++i];
+    } else if (arg == "--zstd") {
+      info.sectioned = false;
+      info.codec = xg::LayoutCodec::kZstd;
+      pack_info.codec = xg::LayoutCodec::kZstd;
+    } else if (arg == "--level" && has_value) {
+      info.level = std::atoi(argv[++i]);
+      pack_info.level = info.level;
+    } else if (arg == "--depfile" && has_value) {
+      depfile_path = argv[++i];
+    } else if (arg == "--pack" && has_value) {
+      pack_path = argv[++i];
+    } else if (!arg.empty() && arg[0] != '-') {
+      input_paths.emplace_back(arg);
+    } else {
+      PrintUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!pack_path.empty() && !input_paths.empty() && output_path.empty() &&
+      depfile_path.empty()) {
+    return PackAssets(pack_path, input_paths, pack_info);
+  }
+  if (!pack_path.empty() || input_paths.size() != 1) {
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+
+  const auto& xml_path = input_paths[0];
+  if (output_path.empty()) {
+    output_path = xml_path.substr(0, xml_path.rfind('.')) + ".xgl";
+  }
+
+  std::vector<std::string> dependencies;
+  const auto layout =
+      xg::Parser::Get().ParseFile(xml_path, xg::ParseMode::kDocument,
+                                  &dependencies);
+  if (!layout) {
+    std::cerr << "failed to parse layout: " << xml_path << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // written next to the output and renamed once it loads, so that a failed
+  // run leaves no output the build tool takes as up to date
+  const auto temp_path = output_path + ".tmp";
+  const auto fail = [&temp_path](const char* message,
+                                 const std::string& path) {
+    std::cerr << message << path << std::endl;
+    std::error_code error;
+    std::filesystem::remove(temp_path, error);
+    return EXIT_FAILURE;
+  };
+
+  if (!layout->Serialize(temp_path, info)) {
+    return fail("failed to write layout: ", output_path);
+  }
+
+  // what the app does at startup
+  if (!xg::Layout::Deserialize(temp_path)) {
+    return fail("failed to load layout: ", output_path);
+  }
+
+  if (!depfile_path.empty() &&
+      !WriteDepfile(depfile_path, output_path, dependencies)) {
+    return fail("failed to write depfile: ", depfile_path);
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, output_path, error);
+  if (error) {
+    return fail("failed to replace layout: ", output_path);
+  }
+
+  size_t size = 0;
+  if (const auto file = xg::MappedFile::Open(output_path)) {
+    size = file->GetSize();
+  }
+  std::cout << xml_path << " -> " << output_path << ": "
+            << layout->node_id_map.size() << " named nodes, " << size
+            << " bytes" << std::endl;
+
+  return 0;
+}